@@ -0,0 +1,666 @@
+#include "stdio.h"
+#include "stdlib.h"
+#include "stdint.h"
+#include "string.h"
+#include "stdarg.h"
+#include "errno.h"
+#include "time.h"
+#include "fcntl.h"
+#include "unistd.h"
+
+#include "nano/json.h"
+
+#ifdef JSON_SHORT_NEXT
+#define ARRAY_LENGTH 30000 /* fits to jsn_next_t length */
+#else
+#define ARRAY_LENGTH 100000
+#endif
+
+#define NUMBERS 1000000
+
+/* ------------------------------------------------------------------------ */
+static double now()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+/* ------------------------------------------------------------------------ */
+static jsn_t *cell_scan(jsn_t *obj, int index)
+{
+	json_foreach(obj, i)
+		if (index == obj[i].id.number)
+			return obj + i;
+
+	return NULL;
+}
+
+
+/* ------------------------------------------------------------------------ */
+static void bench_cells(char const *name, char const *item, int length)
+{
+	size_t size = (strlen(item) + 12) * length + 16;
+	char *text = malloc(size), *p = text;
+	*p++ = '[';
+	for (int i = 0; i < length; ++i)
+		p += sprintf(p, i ? ",%s" : "%s", item);
+	strcpy(p, "]");
+
+	jsn_t *json = json_auto_parse(text, NULL);
+	if (!json) {
+		perror("json_auto_parse");
+		exit(1);
+	}
+
+	int calls = length < 2000 ? length : 2000; /* O(n^2) is too slow, indexes are spread over the array */
+	double t = now();
+	for (int i = 0; i < calls; ++i)
+		if (!cell_scan(json, (int)((long)i * length / calls)))
+			exit(1);
+	double scan = (now() - t) / calls;
+
+	t = now();
+	for (int i = 0; i < calls; ++i)
+		if (!json_cell(json, (int)((long)i * length / calls)))
+			exit(1);
+	double cell = (now() - t) / calls;
+
+	printf("  %-24s %7d elements: json_cell %8.1f ns/call, sibling scan %10.1f ns/call\n",
+		name, length, cell * 1e9, scan * 1e9);
+
+	free(json);
+	free(text);
+}
+
+
+/* ------------------------------------------------------------------------ */
+static char *numbers_text(unsigned int modulo)
+{
+	char *text = malloc(NUMBERS * 12 + 16), *p = text;
+	*p++ = '[';
+	for (unsigned int i = 0; i < NUMBERS; ++i)
+		p += sprintf(p, i ? ",%d" : "%d", (int)(i * 2654435761u % modulo) * (i & 1 ? -1 : 1));
+	strcpy(p, "]");
+	return text;
+}
+
+
+/* ------------------------------------------------------------------------ */
+static void bench_numbers(char const *name, unsigned int modulo)
+{
+	char *text = numbers_text(modulo);
+	size_t length = strlen(text);
+
+	jsn_t *pool = malloc((NUMBERS + 1) * sizeof(jsn_t));
+	double parse = 1e9, match = 1e9, scan = 1e9;
+	for (int k = 0; k < 5; ++k) {
+		double t = now();
+		if (json_parse(pool, NUMBERS + 1, text) != NUMBERS + 1)
+			exit(1);
+		double d = now() - t;
+		parse = d < parse ? d : parse;
+
+		jsn_t num;
+		t = now();
+		for (char *s = text; *s++ != ']'; )
+			if (!match_number(&s, &num))
+				exit(1);
+		d = now() - t;
+		match = d < match ? d : match;
+
+		long sum = 0;
+		t = now();
+		for (char *s = text; *s++ != ']'; )
+			sum += strtol(s, &s, 10);
+		d = now() - t;
+		scan = d < scan ? d : scan;
+		if (sum == 1)
+			printf(" ");
+	}
+
+	printf("  %-12s json_parse %7.1f MB/s, match_number %5.1f ns/number, strtol %5.1f ns/number\n",
+		name, length / parse / 1e6, match / NUMBERS * 1e9, scan / NUMBERS * 1e9);
+
+	free(pool);
+	free(text);
+}
+
+
+#ifdef JSON_FLOATS
+/* ------------------------------------------------------------------------ */
+static void bench_floats(char const *name, char const *format)
+{
+	char *text = malloc(NUMBERS * 32 + 16), *p = text;
+	*p++ = '[';
+	for (unsigned int i = 0; i < NUMBERS; ++i) {
+		if (i)
+			*p++ = ',';
+		p += sprintf(p, format, ((int)(i * 2654435761u % 360000000u) - 180000000) / 1e6 + i % 7 / 3e7);
+	}
+	strcpy(p, "]");
+	size_t length = strlen(text);
+
+	jsn_t *pool = malloc((NUMBERS + 1) * sizeof(jsn_t));
+	double parse = 1e9, match = 1e9, scan = 1e9, print = 1e9, printf_g = 1e9;
+	for (int k = 0; k < 5; ++k) {
+		double t = now();
+		if (json_parse(pool, NUMBERS + 1, text) != NUMBERS + 1)
+			exit(1);
+		double d = now() - t;
+		parse = d < parse ? d : parse;
+
+		jsn_t num;
+		t = now();
+		for (char *s = text; *s++ != ']'; )
+			if (!match_number(&s, &num))
+				exit(1);
+		d = now() - t;
+		match = d < match ? d : match;
+
+		char buf[32];
+		t = now();
+		for (int i = 1; i <= NUMBERS; ++i)
+			float2str(buf, buf + sizeof buf, pool[i].data.floating);
+		d = now() - t;
+		print = d < print ? d : print;
+
+		t = now();
+		for (int i = 1; i <= NUMBERS; ++i)
+			snprintf(buf, sizeof buf, "%.17g", pool[i].data.floating);
+		d = now() - t;
+		printf_g = d < printf_g ? d : printf_g;
+
+		double sum = 0;
+		t = now();
+		for (char *s = text; *s++ != ']'; )
+			sum += strtod(s, &s);
+		d = now() - t;
+		scan = d < scan ? d : scan;
+		if (sum == 1)
+			printf(" ");
+	}
+
+	printf("  %-12s json_parse %7.1f MB/s, match_number %5.1f ns/number, strtod %5.1f ns/number\n",
+		name, length / parse / 1e6, match / NUMBERS * 1e9, scan / NUMBERS * 1e9);
+	printf("  %-12s float2str %5.1f ns/number, snprintf(%%.17g) %5.1f ns/number\n",
+		"", print / NUMBERS * 1e9, printf_g / NUMBERS * 1e9);
+
+	free(pool);
+	free(text);
+}
+#endif
+
+
+/* ------------------------------------------------------------------------ */
+static void bench_parse(char const *name, char *text)
+{
+	size_t length = strlen(text);
+	char *copy = malloc(length + 1);
+	int nodes = json_count_nodes(text);
+	jsn_t *json = malloc(nodes * sizeof(jsn_t));
+
+	double best = 1e9;
+	for (int k = 0; k < 5; ++k) {
+		memcpy(copy, text, length + 1);
+		double t = now();
+		if (json_parse(json, nodes, copy) != nodes) {
+			perror("json_parse");
+			exit(1);
+		}
+		double d = now() - t;
+		best = d < best ? d : best;
+	}
+
+	printf("  %-12s json_parse %7.1f MB/s, %5.1f ns/node\n", name, length / best / 1e6, best / nodes * 1e9);
+
+	free(json);
+	free(copy);
+	free(text);
+}
+
+
+/* ------------------------------------------------------------------------ */
+static void bench_stringify(char const *name, char *text)
+{
+	size_t size = strlen(text) + 16;
+	int nodes = json_count_nodes(text);
+	jsn_t *json = malloc(nodes * sizeof(jsn_t));
+	char *out = malloc(size);
+	if (json_parse(json, nodes, text) != nodes) {
+		perror("json_parse");
+		exit(1);
+	}
+
+	double best = 1e9;
+	for (int k = 0; k < 5; ++k) {
+		double t = now();
+		json_stringify(out, size, json);
+		double d = now() - t;
+		best = d < best ? d : best;
+	}
+
+	printf("  %-12s json_stringify %7.1f MB/s, %5.1f ns/node\n",
+		name, strlen(out) / best / 1e6, best / nodes * 1e9);
+
+#ifdef JSON_STRINGIFY_STREAM_FN
+	int fd = open("/dev/null", O_WRONLY);
+	best = 1e9;
+	for (int k = 0; k < 5; ++k) {
+		double t = now();
+		if (json_stringify_fd(fd, json))
+			exit(1);
+		double d = now() - t;
+		best = d < best ? d : best;
+	}
+	close(fd);
+
+	printf("  %-12s json_stringify_fd(/dev/null) %7.1f MB/s\n", "", strlen(out) / best / 1e6);
+#endif
+
+	free(out);
+	free(json);
+	free(text);
+}
+
+
+/* ------------------------------------------------------------------------ */
+static char *repeat_text(char const *item, int count)
+{
+	size_t length = strlen(item);
+	char *text = malloc((length + 1) * count + 2), *p = text;
+	*p++ = '[';
+	for (int i = 0; i < count; ++i) {
+		if (i)
+			*p++ = ',';
+		memcpy(p, item, length);
+		p += length;
+	}
+	strcpy(p, "]");
+	return text;
+}
+
+
+#ifdef BENCH_COUNT_ALLOCS
+/* ------------------------------------------------------------------------ */
+/* linked with -Wl,--wrap=malloc,--wrap=realloc,--wrap=calloc */
+static long allocs;
+
+void *__real_malloc(size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void *__real_calloc(size_t n, size_t size);
+
+void *__wrap_malloc(size_t size);
+void *__wrap_realloc(void *ptr, size_t size);
+void *__wrap_calloc(size_t n, size_t size);
+
+void *__wrap_malloc(size_t size) { ++allocs; return __real_malloc(size); }
+void *__wrap_realloc(void *ptr, size_t size) { ++allocs; return __real_realloc(ptr, size); }
+void *__wrap_calloc(size_t n, size_t size) { ++allocs; return __real_calloc(n, size); }
+#else
+static long allocs = -1; /* not counted */
+#endif
+
+
+/* ------------------------------------------------------------------------ */
+/* synthetic corpora of the suite */
+
+#ifdef JSON_SHORT_NEXT
+#define SUITE_SIZE (192 << 10) /* approximate corpus text size, fits to jsn_next_t offsets */
+#else
+#define SUITE_SIZE (4 << 20)
+#endif
+
+typedef struct {
+	char *text;
+	size_t length, size;
+} corpus_t;
+
+/* ------------------------------------------------------------------------ */
+static void corpus_printf(corpus_t *c, char const *format, ...)
+{
+	if (c->size - c->length < 1024)
+		c->text = realloc(c->text, c->size = c->size * 2 + 4096);
+	va_list ap;
+	va_start(ap, format);
+	c->length += vsnprintf(c->text + c->length, c->size - c->length, format, ap);
+	va_end(ap);
+}
+
+
+/* ------------------------------------------------------------------------ */
+static void corpus_twitter(corpus_t *c)
+{
+	static char const *const words[] = { "json", "parser", "embedded", "nano", "fast", "caf\\u00e9", "\\\"quoted\\\"", "C99" };
+	corpus_printf(c, "{\"statuses\":[");
+	for (unsigned int i = 0; c->length < SUITE_SIZE; ++i) {
+		unsigned int r = i * 2654435761u;
+		corpus_printf(c, "%s{\"id\":%u,\"id_str\":\"%u\",\"text\":\"@user%u %s %s %s #%s https://t.co/%x\",",
+			i ? "," : "", r % 1000000000, r % 1000000000, r % 977, words[r % 8], words[r / 8 % 8], words[r / 64 % 8], words[r / 512 % 8], r);
+		corpus_printf(c, "\"user\":{\"id\":%u,\"name\":\"User %u\",\"screen_name\":\"user%u\",\"followers_count\":%u,"
+			"\"verified\":%s,\"description\":\"line one\\nline two\\t%s\"},",
+			r % 977, r % 977, r % 977, r % 100000, r & 1 ? "true" : "false", words[r / 4096 % 8]);
+		corpus_printf(c, "\"entities\":{\"hashtags\":[{\"text\":\"%s\",\"indices\":[%u,%u]}],\"urls\":[],\"user_mentions\":[]},"
+			"\"retweet_count\":%u,\"favorited\":false,\"coordinates\":null,\"lang\":\"en\"}",
+			words[r % 8], r % 40, r % 40 + 8, r % 5000);
+	}
+	corpus_printf(c, "]}");
+}
+
+
+/* ------------------------------------------------------------------------ */
+static void corpus_numbers(corpus_t *c)
+{
+	corpus_printf(c, "[");
+	for (unsigned int i = 0; c->length < SUITE_SIZE; ++i) {
+		corpus_printf(c, i ? ",[" : "[");
+		for (unsigned int j = 0; j < 32; ++j)
+			corpus_printf(c, j ? ",%d" : "%d", (int)((i * 32 + j) * 2654435761u % 2000001) - 1000000);
+		corpus_printf(c, "]");
+	}
+	corpus_printf(c, "]");
+}
+
+
+/* ------------------------------------------------------------------------ */
+static void corpus_deep(corpus_t *c)
+{
+	int depth = JSON_MAX_DEPTH - 2 < 100 ? JSON_MAX_DEPTH - 2 : 100;
+	corpus_printf(c, "[");
+	for (unsigned int i = 0; c->length < SUITE_SIZE; ++i) {
+		corpus_printf(c, i ? "," : "");
+		for (int d = 0; d < depth; ++d)
+			corpus_printf(c, d & 1 ? "{\"k\":" : "[%d,", d);
+		corpus_printf(c, "%u", i);
+		for (int d = depth - 1; d >= 0; --d)
+			corpus_printf(c, d & 1 ? "}" : "]");
+	}
+	corpus_printf(c, "]");
+}
+
+
+/* ------------------------------------------------------------------------ */
+static void corpus_wide(corpus_t *c)
+{
+	corpus_printf(c, "[");
+	for (unsigned int i = 0; c->length < SUITE_SIZE; ++i) {
+		corpus_printf(c, i ? ",{" : "{");
+		for (unsigned int k = 0; k < 1000; ++k)
+			corpus_printf(c, k ? ",\"key%04u\":%u" : "\"key%04u\":%u", k * 7919 % 1000, k);
+		corpus_printf(c, "}");
+	}
+	corpus_printf(c, "]");
+}
+
+
+/* ------------------------------------------------------------------------ */
+static void corpus_escapes(corpus_t *c)
+{
+	corpus_printf(c, "[");
+	for (unsigned int i = 0; c->length < SUITE_SIZE; ++i)
+		corpus_printf(c, "%s\"%u:\\t\\\"tab\\\" and \\\\back\\\\slash\\n\\u00e9\\u0001\\/ %u\\r\\n\"", i ? "," : "", i, i * 31);
+	corpus_printf(c, "]");
+}
+
+
+/* ------------------------------------------------------------------------ */
+/* clean strings of 64 bytes to 4 KB, the case of vectorized string scanning */
+static void corpus_strings(corpus_t *c)
+{
+	static char const words[] = "lorem ipsum dolor sit amet consectetur adipiscing elit sed do eiusmod tempor ";
+	corpus_printf(c, "[");
+	for (unsigned int i = 0; c->length < SUITE_SIZE; ++i) {
+		unsigned int length = 64 << i % 7;
+		corpus_printf(c, i ? ",\"" : "\"");
+		for (unsigned int n = 0; n < length; n += sizeof words - 1)
+			corpus_printf(c, "%.*s", (int)(length - n < sizeof words - 1 ? length - n : sizeof words - 1), words);
+		corpus_printf(c, "\"");
+	}
+	corpus_printf(c, "]");
+}
+
+
+/* ------------------------------------------------------------------------ */
+static void corpus_fail(char const *name, char const *phase)
+{
+	printf("  %s: %s [FAILED] (%s)\n", name, phase, strerror(errno));
+	exit(1);
+}
+
+
+/* ------------------------------------------------------------------------ */
+static double best_of(double *best, double t)
+{
+	double d = now() - t;
+	return *best = d < *best ? d : *best;
+}
+
+
+/* ------------------------------------------------------------------------ */
+static void bench_corpus(char const *name, void (*make)(corpus_t *c), char const *path, char const *item)
+{
+	corpus_t c = { .text = NULL };
+	make(&c);
+	char *text = malloc(c.length + 1);
+	int nodes = json_count_nodes(c.text);
+	jsn_t *json = malloc(nodes * sizeof(jsn_t));
+	double mb = c.length / 1e6;
+	int runs = 5;
+
+	double parse = 1e9;
+	for (int k = 0; k < runs; ++k) {
+		memcpy(text, c.text, c.length + 1);
+		double t = now();
+		if (json_parse(json, nodes, text) != nodes)
+			corpus_fail(name, "json_parse");
+		best_of(&parse, t);
+	}
+
+	double auto_parse = 0;
+	long auto_allocs = 0;
+#ifdef JSON_AUTO_PARSE_FN
+	auto_parse = 1e9;
+	for (int k = 0; k < runs; ++k) {
+		memcpy(text, c.text, c.length + 1);
+		long a = allocs;
+		double t = now();
+		jsn_t *j = json_auto_parse(text, NULL);
+		best_of(&auto_parse, t);
+		auto_allocs = allocs - a;
+		if (!j)
+			corpus_fail(name, "json_auto_parse");
+		free(j);
+	}
+	memcpy(text, c.text, c.length + 1);
+	json_parse(json, nodes, text);
+#endif
+
+	/* lookups in the first object/array of the root */
+	int calls = 100000;
+	double get = 0;
+#ifdef JSON_GET_FN
+	get = 1e9;
+	for (int k = 0; k < runs; ++k) {
+		double t = now();
+		for (int i = 0; i < calls; ++i)
+			if (!json_get(json, path))
+				corpus_fail(name, path);
+		best_of(&get, t);
+	}
+#endif
+
+	/* json_item() in the root or its first object, the middle json_cell() of an array root */
+	jsn_t *obj = json->type == JS_OBJECT ? json : json_cell(json, 0);
+	double lookup = 1e9;
+	for (int k = 0; k < runs; ++k) {
+		double t = now();
+		for (int i = 0; i < calls; ++i)
+			if (obj->type == JS_OBJECT ? !json_item(obj, item) : !json_cell(json, json->data.length / 2))
+				corpus_fail(name, "json_item/json_cell");
+		best_of(&lookup, t);
+	}
+
+	size_t length = json_stringify_len(json);
+	char *out = malloc(length + 1);
+	double stringify = 1e9;
+	for (int k = 0; k < runs; ++k) {
+		double t = now();
+		json_stringify(out, length + 1, json);
+		best_of(&stringify, t);
+	}
+
+	printf("  %-8s %5.1f MB %8d nodes | parse %6.1f MB/s %6.1f Mnodes/s | auto %6.1f MB/s %4ld allocs"
+		" | get %6.1f ns | item/cell %6.1f ns | stringify %6.1f MB/s\n",
+		name, mb, nodes, mb / parse, nodes / parse / 1e6, auto_parse ? mb / auto_parse : 0., auto_allocs,
+		get / calls * 1e9, lookup / calls * 1e9, length / stringify / 1e6);
+
+	free(out);
+	free(json);
+	free(text);
+	free(c.text);
+}
+
+
+#ifdef JSON_NDJSON_FN
+/* ------------------------------------------------------------------------ */
+/* statuses of the twitter corpus a line each */
+static void bench_ndjson(void)
+{
+	corpus_t c = { .text = NULL };
+	corpus_twitter(&c);
+	jsn_t *json = json_auto_parse(c.text, NULL);
+	jsn_t *statuses = json_item(json, "statuses");
+	size_t size = c.length * 2;
+	char *lines = malloc(size), *text = malloc(size), *t = lines;
+	json_foreach(statuses, i) {
+		t += strlen(json_stringify(t, lines + size - t, statuses + i));
+		*t++ = '\n';
+	}
+	*t = 0;
+	double mb = (t - lines) / 1e6;
+
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	for (long threads = 1; threads <= cpus; threads = threads * 2 > cpus && threads < cpus ? cpus : threads * 2) {
+		double best = 1e9;
+		jsn_ndjson_t docs;
+		for (int k = 0; k < 5; ++k) {
+			memcpy(text, lines, t - lines + 1);
+			double start = now();
+			if (json_ndjson_parse(&docs, text, (int)threads) != (int)docs.length)
+				corpus_fail("ndjson", "json_ndjson_parse");
+			best_of(&best, start);
+			json_ndjson_free(&docs);
+		}
+		printf("  ndjson   %5.1f MB %8u lines | %2ld threads %6.1f MB/s\n", mb, statuses->data.length, threads, mb / best);
+	}
+
+	free(text);
+	free(lines);
+	free(json);
+	free(c.text);
+}
+#endif
+
+
+/* ------------------------------------------------------------------------ */
+static void bench_suite(void)
+{
+	printf("Bench suite (opts:%s%s%s%s%s%s%s%s, sizeof jsn_t %u, allocs %s)\n",
+#ifdef JSON_FLOATS
+		" fl",
+#else
+		"",
+#endif
+#ifdef JSON_64BITS_INTEGERS
+		" wi",
+#else
+		"",
+#endif
+#ifdef JSON_HEX_NUMBERS
+		" hx",
+#else
+		"",
+#endif
+#ifdef JSON_SHORT_NEXT
+		" sn",
+#else
+		"",
+#endif
+#ifdef JSON_PACKED
+		" pk",
+#else
+		"",
+#endif
+#ifdef JSON_HASH_INDEX
+		" hi",
+#else
+		"",
+#endif
+#ifdef JSON_SIMD
+		" simd",
+#else
+		"",
+#endif
+#ifdef JSON_TWO_STAGE
+		" ts",
+#else
+		"",
+#endif
+		(unsigned int)sizeof(jsn_t), allocs < 0 ? "not counted" : "counted");
+
+	bench_corpus("twitter", corpus_twitter, ".statuses[7].user.screen_name", "statuses");
+	bench_corpus("numbers", corpus_numbers, "[5][31]", NULL);
+	bench_corpus("deep", corpus_deep, "[1][1].k[1]", NULL);
+	bench_corpus("wide", corpus_wide, "[2].key0999", "key0500");
+	bench_corpus("escapes", corpus_escapes, "[1000]", NULL);
+	bench_corpus("strings", corpus_strings, "[100]", NULL);
+#ifdef JSON_NDJSON_FN
+	bench_ndjson();
+#endif
+}
+
+
+/* ------------------------------------------------------------------------ */
+int main(int argc, char *argv[])
+{
+	int suite = argc < 2 || !strcmp(argv[1], "suite");
+	int micro = argc < 2 || !strcmp(argv[1], "micro");
+	if (suite)
+		bench_suite();
+	if (!micro)
+		return 0;
+
+	printf("Bench json_cell()\n");
+	bench_cells("numbers", "12345", ARRAY_LENGTH);
+	bench_cells("objects", "{\"a\":1}", ARRAY_LENGTH);
+	bench_cells("arrays", "[1,2]", ARRAY_LENGTH);
+
+	printf("Bench numbers\n");
+	bench_numbers("1-3 digits", 1000);
+	bench_numbers("4-6 digits", 1000000);
+	bench_numbers("7-9 digits", 1000000000);
+
+#ifdef JSON_FLOATS
+	printf("Bench floats\n");
+	bench_floats("coordinates", "%.6f");
+	bench_floats("exponents", "%.9e");
+	bench_floats("round trip", "%.17g");
+#endif
+
+	printf("Bench json_parse()\n");
+	bench_parse("objects", repeat_text("{\"id\":12345,\"ok\":true,\"tags\":[1,2,3]}", NUMBERS / 6));
+	bench_parse("nested", repeat_text("[[[[[[[[{\"a\":[[[[{\"b\":[1]}]]]]}]]]]]]]]", NUMBERS / 16));
+
+	printf("Bench json_stringify()\n");
+	bench_stringify("numbers", numbers_text(1000000000));
+	bench_stringify("literals", repeat_text("true,false,null", NUMBERS / 3));
+	bench_stringify("strings", repeat_text("\"Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor "
+		"incididunt ut labore et dolore magna aliqua. Ut enim ad minim veniam, quis nostrud exercitation\\n\"", NUMBERS / 10));
+	bench_stringify("objects", repeat_text("{\"id\":12345,\"ok\":true,\"tags\":[1,2,3]}", NUMBERS / 6));
+#ifdef JSON_FLOATS
+	bench_stringify("coordinates", repeat_text("[37.371991,-122.02602]", NUMBERS / 3));
+#endif
+
+	return 0;
+}
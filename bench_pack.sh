@@ -0,0 +1,122 @@
+#!/bin/sh
+
+
+#JSON_FLOATS
+#JSON_64BITS_INTEGERS
+#JSON_HEX_NUMBERS
+#JSON_SHORT_NEXT
+#JSON_PACKED
+#feature groups of bench_features():
+#  si JSON_SIMD, ts JSON_TWO_STAGE, ix JSON_HASH_INDEX and JSON_ARRAY_INDEX,
+#  lu JSON_LAZY_UNESCAPE, st JSON_STATS, ac JSON_AUTO_PARSE_COUNT, nd JSON_NDJSON_FN
+
+bench_basic()
+{
+	echo "------------------------------------------------------------------------------"
+	echo "build bench $*"
+
+	local hx fl wi sn pk ft ohx ofl owi osn opk osi ots oix olu ost oac ond
+	hx="-"; fl="-"; wi="-"; sn="-"; pk="-"
+	ohx="OFF"; ofl="OFF"; owi="OFF"; osn="OFF"; opk="OFF"
+	ft=""; osi="OFF"; ots="OFF"; oix="OFF"; olu="OFF"; ost="OFF"; oac="OFF"; ond="OFF"
+	for a in $*; do
+		case $a in
+		hx)
+			hx="h"
+			ohx="ON"
+			;;
+		fl)
+			fl="f"
+			ofl="ON"
+			;;
+		wi)
+			wi="i"
+			owi="ON"
+			;;
+		sn)
+			sn="s"
+			osn="ON"
+			;;
+		pk)
+			pk="p"
+			opk="ON"
+			;;
+		si)
+			ft="${ft}_si"
+			osi="ON"
+			;;
+		ts)
+			ft="${ft}_ts"
+			ots="ON"
+			;;
+		ix)
+			ft="${ft}_ix"
+			oix="ON"
+			;;
+		lu)
+			ft="${ft}_lu"
+			olu="ON"
+			;;
+		st)
+			ft="${ft}_st"
+			ost="ON"
+			;;
+		ac)
+			ft="${ft}_ac"
+			oac="ON"
+			;;
+		nd)
+			ft="${ft}_nd"
+			ond="ON"
+			;;
+		esac
+	done
+
+	local name
+	name=nj_bench_$hx$wi$fl$sn$pk$ft
+	mkdir -p bench_build/$name && (cd bench_build/$name && cmake -DJSON_HEX_NUMBERS=$ohx -DJSON_64BITS_INTEGERS=$owi -DJSON_FLOATS=$ofl -DJSON_SHORT_NEXT=$osn -DJSON_PACKED=$opk -DJSON_SIMD=$osi -DJSON_TWO_STAGE=$ots -DJSON_HASH_INDEX=$oix -DJSON_ARRAY_INDEX=$oix -DJSON_LAZY_UNESCAPE=$olu -DJSON_STATS=$ost -DJSON_AUTO_PARSE_COUNT=$oac -DJSON_NDJSON_FN=$ond -DBUILD_TESTS=OFF -DBUILD_BENCH=ON ../.. && make) || exit 1
+	mv bench_build/$name/bench $name
+	echo "./$name \$* || exit 1" >> bench.sh
+	echo
+}
+
+bench_hex()
+{
+	bench_basic $* && bench_basic $* hx
+}
+
+bench_64bit()
+{
+	bench_hex $* && bench_hex $* wi
+}
+
+bench_floats()
+{
+	bench_64bit $* && bench_64bit $* fl
+}
+
+bench_short_next()
+{
+	bench_floats $* && bench_floats $* sn
+}
+
+bench_packet_next()
+{
+	bench_short_next $* && bench_short_next $* pk
+}
+
+bench_features()
+{
+	bench_packet_next $* && bench_packet_next $* si ts ix && bench_packet_next $* si lu st ac nd && bench_packet_next $* ix lu ac
+}
+
+case $1 in
+clean)
+	rm -rf nj_bench* bench.sh bench_build
+	exit 0
+	;;
+esac
+
+echo "#!/bin/sh" > bench.sh
+bench_features
+chmod +x bench.sh
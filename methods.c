@@ -8,6 +8,100 @@
 
 #include "nano/json.h"
 
+#if defined(JSON_HASH_INDEX) || defined(JSON_ARRAY_INDEX)
+
+typedef
+struct jsn_bucket {
+	jsn_next_t offset; /* offset of element from object node (0 - empty) */
+}
+#ifdef JSON_PACKED
+__attribute__((packed))
+#endif
+jsn_bucket_t;
+
+#endif
+
+#ifdef JSON_HASH_INDEX
+
+/* ------------------------------------------------------------------------ */
+static int hash_size(int length)
+{
+	int size = 4;
+	while (size < 2 * length)
+		size <<= 1;
+	return size;
+}
+
+
+/* ------------------------------------------------------------------------ */
+unsigned int json_hash(char const *s)
+{
+	uint32_t h = 2166136261u; /* FNV-1a */
+	while (*s)
+		h = (h ^ (unsigned char)*s++) * 16777619u;
+	return h;
+}
+
+
+/* ------------------------------------------------------------------------ */
+int json_hash_nodes(int length)
+{
+	return (hash_size(length) * sizeof(jsn_bucket_t) + sizeof(jsn_t) - 1) / sizeof(jsn_t);
+}
+
+
+/* ------------------------------------------------------------------------ */
+void json_hash_build(jsn_t *obj)
+{
+	unsigned int mask = hash_size(obj->data.length) - 1;
+	jsn_bucket_t *table = (jsn_bucket_t *)(obj + obj->data.index);
+	memset(table, 0, (mask + 1) * sizeof *table);
+
+	json_foreach(obj, index) {
+		unsigned int i = json_hash(json_unescaped_id(obj + index)) & mask;
+		while (table[i].offset)
+			i = (i + 1) & mask;
+		table[i].offset = index;
+	}
+}
+
+#endif
+
+#ifdef JSON_HASH_INDEX
+
+/* ------------------------------------------------------------------------ */
+jsn_t *json_item_hash(jsn_t *obj, char const *id, unsigned int hash)
+{
+	if (obj->type != JS_OBJECT)
+		return errno = ENOTDIR, NULL;
+
+	if (obj->data.index) {
+		unsigned int mask = hash_size(obj->data.length) - 1;
+		jsn_bucket_t *table = (jsn_bucket_t *)(obj + obj->data.index);
+		for (unsigned int i = hash & mask; table[i].offset; i = (i + 1) & mask)
+			if (!strcmp(id, json_unescaped_id(obj + table[i].offset)))
+				return obj + table[i].offset;
+
+		return errno = ENOENT, NULL;
+	}
+
+	json_foreach(obj, index)
+		if (!strcmp(id, json_unescaped_id(obj + index)))
+			return obj + index;
+
+	return errno = ENOENT, NULL;
+}
+
+
+/* ------------------------------------------------------------------------ */
+jsn_t *json_item(jsn_t *obj, char const *id)
+{
+	/* do not hash the id for objects without table */
+	return json_item_hash(obj, id, obj->type == JS_OBJECT && obj->data.index ? json_hash(id) : 0);
+}
+
+#else
+
 /* ------------------------------------------------------------------------ */
 jsn_t *json_item(jsn_t *obj, char const *id)
 {
@@ -15,12 +109,88 @@ jsn_t *json_item(jsn_t *obj, char const *id)
 		return errno = ENOTDIR, NULL;
 
 	json_foreach(obj, index)
-		if (!strcmp(id, obj[index].id.string))
+		if (!strcmp(id, json_unescaped_id(obj + index)))
 			return obj + index;
 
 	return errno = ENOENT, NULL;
 }
 
+#endif
+
+
+/* ------------------------------------------------------------------------ */
+int json_items(jsn_t *obj, char const *const *ids, jsn_t **items, int count)
+{
+	if (obj->type != JS_OBJECT)
+		return errno = ENOTDIR, -1;
+
+	memset(items, 0, count * sizeof *items);
+	int found = 0;
+
+#ifdef JSON_HASH_INDEX
+	if (obj->data.index) {
+		for (int i = 0; i < count; ++i)
+			found += !!(items[i] = json_item_hash(obj, ids[i], json_hash(ids[i])));
+
+		return found;
+	}
+#endif
+
+	json_foreach(obj, index) {
+		char const *id = json_unescaped_id(obj + index);
+		for (int lo = 0, hi = count; lo < hi; ) { /* binary search in sorted ids */
+			int mid = (lo + hi) / 2;
+			int cmp = strcmp(id, ids[mid]);
+			if (cmp < 0)
+				hi = mid;
+			else
+				if (cmp > 0)
+					lo = mid + 1;
+				else {
+					if (!items[mid]) { /* the first of duplicated keys like json_item() */
+						items[mid] = obj + index;
+						if (++found == count)
+							return found;
+					}
+					break;
+				}
+		}
+	}
+
+	if (found < count)
+		errno = ENOENT;
+	return found;
+}
+
+
+#ifdef JSON_ARRAY_INDEX
+
+/* ------------------------------------------------------------------------ */
+int json_cells_nodes(int length)
+{
+	return (length * sizeof(jsn_bucket_t) + sizeof(jsn_t) - 1) / sizeof(jsn_t);
+}
+
+
+/* ------------------------------------------------------------------------ */
+void json_cells_build(jsn_t *arr)
+{
+	jsn_bucket_t *table = (jsn_bucket_t *)(arr + arr->data.index);
+	json_foreach(arr, offset)
+		table++->offset = offset;
+}
+
+#endif
+
+/* ------------------------------------------------------------------------ */
+int json_length(jsn_t *obj)
+{
+	if (obj->type != JS_ARRAY && obj->type != JS_OBJECT)
+		return errno = ENOTDIR, -1;
+
+	return obj->data.length;
+}
+
 
 /* ------------------------------------------------------------------------ */
 jsn_t *json_cell(jsn_t *obj, int index)
@@ -28,6 +198,23 @@ jsn_t *json_cell(jsn_t *obj, int index)
 	if (obj->type != JS_ARRAY)
 		return errno = ENOTDIR, NULL;
 
+	int length = obj->data.length;
+	if (index < 0 || index >= length)
+		return errno = ENOENT, NULL;
+
+	/*
+		If the last element is the node right after the array's elements count
+		then every element takes exactly one node. A nested node at this place
+		would have a smaller index, so the check has no false positives.
+	*/
+	if (obj[length].id_type == JS_NUMBER && obj[length].id.number == length - 1)
+		return obj + 1 + index;
+
+#ifdef JSON_ARRAY_INDEX
+	if (obj->data.index)
+		return obj + ((jsn_bucket_t *)(obj + obj->data.index))[index].offset;
+#endif
+
 	json_foreach(obj, i)
 		if (index == obj[i].id.number)
 			return obj + i;
@@ -55,7 +242,7 @@ int json_boolean(jsn_t *node, int absent)
 		return (int)round(node->data.floating) ? 1 : 0;
 #endif
 	case JS_STRING:
-		return node->data.string[0] ? 1 : 0;
+		return json_unescaped_string(node)[0] ? 1 : 0;
 	case JS_ARRAY:
 	case JS_OBJECT:
 		return 1;
@@ -89,7 +276,8 @@ jsn_number_t json_number(jsn_t *node, jsn_number_t absent)
 #endif
 	case JS_STRING:;
 		jsn_t num;
-		char *s = node->data.string;
+		char *s = json_unescaped_string(node);
+		s += strspn(s, " \t\n\v\f\r"); /* leading spaces are skipped like strtol() did */
 		if (!match_number(&s, &num))
 			return 0;
 		return json_number(&num, absent);
@@ -121,7 +309,8 @@ double json_float(jsn_t *node, double absent)
 		return node->data.floating;
 	case JS_STRING:;
 		jsn_t num;
-		char *s = node->data.string;
+		char *s = json_unescaped_string(node);
+		s += strspn(s, " \t\n\v\f\r"); /* like strtod() */
 		if (!*s)
 			return (double)0;
 		if (!match_number(&s, &num))
@@ -138,35 +327,338 @@ double json_float(jsn_t *node, double absent)
 
 #endif
 
-#ifdef JSON_64BITS_INTEGERS
-#define NSB_LENGTH 16
-#else
-#define NSB_LENGTH 32
-#endif
+#define NSB_LENGTH JSN_NUMBER_STRING_SIZE /* fits -9223372036854775808 and -0.0000012345678901234567 */
 #define NSB_NUM    16 /* should be degree of 2 ( 2,4,8,16,32...) */
 
 /* ------------------------------------------------------------------------ */
+/* ring of buffers of the calling thread */
 static char *get_number_string_buffer()
 {
-	static char bufs[NSB_NUM][NSB_LENGTH/* string length */];
-	static int i = 0;
+	static __thread char bufs[NSB_NUM][NSB_LENGTH/* string length */];
+	static __thread unsigned int i = 0;
 	return bufs[i++ & (NSB_NUM-1)];
 }
 
+/* ------------------------------------------------------------------------ */
+static char const digit_pairs[] =
+	"0001020304050607080910111213141516171819"
+	"2021222324252627282930313233343536373839"
+	"4041424344454647484950515253545556575859"
+	"6061626364656667686970717273747576777879"
+	"8081828384858687888990919293949596979899";
+
+/* ------------------------------------------------------------------------ */
+/* writes to [p, e) only, zero terminated if fits, returns p + length even if truncated */
+char *str2buf(char *p, char *e, char const *s, size_t length)
+{
+	if (p < e) {
+		size_t n = length < (size_t)(e - p) ? length : (size_t)(e - p);
+		memcpy(p, s, n);
+		if (p + n < e)
+			p[n] = 0;
+	}
+	return p + length;
+}
+
+/* ------------------------------------------------------------------------ */
+char *number2str(char *p, char *e, jsn_number_t n)
+{
+	char buf[24], *s = buf + sizeof buf;
+	uint64_t u = n < 0 ? 0 - (uint64_t)n : (uint64_t)n;
+	for (; u >= 100; u /= 100)
+		memcpy(s -= 2, digit_pairs + u % 100 * 2, 2);
+	if (u >= 10)
+		memcpy(s -= 2, digit_pairs + u * 2, 2);
+	else
+		*--s = (char)('0' + u);
+	if (n < 0)
+		*--s = '-';
+	return str2buf(p, e, s, (size_t)(buf + sizeof buf - s));
+}
+
 #ifdef JSON_FLOATS
+/* ------------------------------------------------------------------------ */
+/* Grisu2 of Florian Loitsch "Printing Floating-Point Numbers Quickly and
+   Accurately with Integers": the shortest (in 99.9% of cases) digits string
+   which converts back to the same double. Integer arithmetic only. */
+
+typedef struct {
+	uint64_t f;
+	int e;
+} diy_fp_t;
+
+/* normalized 10^k, k = -348, -340, ..., 340 */
+static struct {
+	uint64_t f;
+	int16_t e;
+} const cached_powers[] = {
+	{ 0xfa8fd5a0081c0288, -1220 }, { 0xbaaee17fa23ebf76, -1193 }, { 0x8b16fb203055ac76, -1166 },
+	{ 0xcf42894a5dce35ea, -1140 }, { 0x9a6bb0aa55653b2d, -1113 }, { 0xe61acf033d1a45df, -1087 },
+	{ 0xab70fe17c79ac6ca, -1060 }, { 0xff77b1fcbebcdc4f, -1034 }, { 0xbe5691ef416bd60c, -1007 },
+	{ 0x8dd01fad907ffc3c,  -980 }, { 0xd3515c2831559a83,  -954 }, { 0x9d71ac8fada6c9b5,  -927 },
+	{ 0xea9c227723ee8bcb,  -901 }, { 0xaecc49914078536d,  -874 }, { 0x823c12795db6ce57,  -847 },
+	{ 0xc21094364dfb5637,  -821 }, { 0x9096ea6f3848984f,  -794 }, { 0xd77485cb25823ac7,  -768 },
+	{ 0xa086cfcd97bf97f4,  -741 }, { 0xef340a98172aace5,  -715 }, { 0xb23867fb2a35b28e,  -688 },
+	{ 0x84c8d4dfd2c63f3b,  -661 }, { 0xc5dd44271ad3cdba,  -635 }, { 0x936b9fcebb25c996,  -608 },
+	{ 0xdbac6c247d62a584,  -582 }, { 0xa3ab66580d5fdaf6,  -555 }, { 0xf3e2f893dec3f126,  -529 },
+	{ 0xb5b5ada8aaff80b8,  -502 }, { 0x87625f056c7c4a8b,  -475 }, { 0xc9bcff6034c13053,  -449 },
+	{ 0x964e858c91ba2655,  -422 }, { 0xdff9772470297ebd,  -396 }, { 0xa6dfbd9fb8e5b88f,  -369 },
+	{ 0xf8a95fcf88747d94,  -343 }, { 0xb94470938fa89bcf,  -316 }, { 0x8a08f0f8bf0f156b,  -289 },
+	{ 0xcdb02555653131b6,  -263 }, { 0x993fe2c6d07b7fac,  -236 }, { 0xe45c10c42a2b3b06,  -210 },
+	{ 0xaa242499697392d3,  -183 }, { 0xfd87b5f28300ca0e,  -157 }, { 0xbce5086492111aeb,  -130 },
+	{ 0x8cbccc096f5088cc,  -103 }, { 0xd1b71758e219652c,   -77 }, { 0x9c40000000000000,   -50 },
+	{ 0xe8d4a51000000000,   -24 }, { 0xad78ebc5ac620000,     3 }, { 0x813f3978f8940984,    30 },
+	{ 0xc097ce7bc90715b3,    56 }, { 0x8f7e32ce7bea5c70,    83 }, { 0xd5d238a4abe98068,   109 },
+	{ 0x9f4f2726179a2245,   136 }, { 0xed63a231d4c4fb27,   162 }, { 0xb0de65388cc8ada8,   189 },
+	{ 0x83c7088e1aab65db,   216 }, { 0xc45d1df942711d9a,   242 }, { 0x924d692ca61be758,   269 },
+	{ 0xda01ee641a708dea,   295 }, { 0xa26da3999aef774a,   322 }, { 0xf209787bb47d6b85,   348 },
+	{ 0xb454e4a179dd1877,   375 }, { 0x865b86925b9bc5c2,   402 }, { 0xc83553c5c8965d3d,   428 },
+	{ 0x952ab45cfa97a0b3,   455 }, { 0xde469fbd99a05fe3,   481 }, { 0xa59bc234db398c25,   508 },
+	{ 0xf6c69a72a3989f5c,   534 }, { 0xb7dcbf5354e9bece,   561 }, { 0x88fcf317f22241e2,   588 },
+	{ 0xcc20ce9bd35c78a5,   614 }, { 0x98165af37b2153df,   641 }, { 0xe2a0b5dc971f303a,   667 },
+	{ 0xa8d9d1535ce3b396,   694 }, { 0xfb9b7cd9a4a7443c,   720 }, { 0xbb764c4ca7a44410,   747 },
+	{ 0x8bab8eefb6409c1a,   774 }, { 0xd01fef10a657842c,   800 }, { 0x9b10a4e5e9913129,   827 },
+	{ 0xe7109bfba19c0c9d,   853 }, { 0xac2820d9623bf429,   880 }, { 0x80444b5e7aa7cf85,   907 },
+	{ 0xbf21e44003acdd2d,   933 }, { 0x8e679c2f5e44ff8f,   960 }, { 0xd433179d9c8cb841,   986 },
+	{ 0x9e19db92b4e31ba9,  1013 }, { 0xeb96bf6ebadf77d9,  1039 }, { 0xaf87023b9bf0ee6b,  1066 },
+};
+
+static uint32_t const pow10_u32[] = {
+	1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+
+static uint64_t const pow10_u64[] = {
+	1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull,
+	1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull, 10000000000000ull,
+	100000000000000ull, 1000000000000000ull, 10000000000000000ull, 100000000000000000ull,
+	1000000000000000000ull, 10000000000000000000ull
+};
+
+#define DP_HIDDEN_BIT ((uint64_t)1 << 52)
+
+/* ------------------------------------------------------------------------ */
+static diy_fp_t diy_normalize(diy_fp_t v)
+{
+	int shift = __builtin_clzll(v.f);
+	v.f <<= shift;
+	v.e -= shift;
+	return v;
+}
+
+/* ------------------------------------------------------------------------ */
+static diy_fp_t diy_multiply(diy_fp_t x, diy_fp_t y)
+{
+	uint64_t const M32 = 0xFFFFFFFFu;
+	uint64_t a = x.f >> 32, b = x.f & M32, c = y.f >> 32, d = y.f & M32;
+	uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+	uint64_t tmp = (bd >> 32) + (ad & M32) + (bc & M32) + ((uint64_t)1 << 31); /* round */
+	return (diy_fp_t){ ac + (ad >> 32) + (bc >> 32) + (tmp >> 32), x.e + y.e + 64 };
+}
+
+/* ------------------------------------------------------------------------ */
+static diy_fp_t cached_power(int e, int *K)
+{
+	int x = -61 - e;
+	int k = (x * 78913 >> 18) + (x != 0) + 347; /* ceil(x * log10(2)) + 347 */
+	int index = (k >> 3) + 1;
+	*K = -(-348 + index * 8);
+	return (diy_fp_t){ cached_powers[index].f, cached_powers[index].e };
+}
+
+/* ------------------------------------------------------------------------ */
+static void grisu_round(char *buf, int len, uint64_t delta, uint64_t rest, uint64_t ten_kappa, uint64_t wp_w)
+{
+	while (rest < wp_w && delta - rest >= ten_kappa &&
+			(rest + ten_kappa < wp_w || wp_w - rest > rest + ten_kappa - wp_w)) {
+		--buf[len - 1];
+		rest += ten_kappa;
+	}
+}
+
+/* ------------------------------------------------------------------------ */
+static int digit_gen(diy_fp_t W, diy_fp_t Mp, uint64_t delta, char *buf, int *K)
+{
+	diy_fp_t one = { (uint64_t)1 << -Mp.e, Mp.e };
+	uint64_t wp_w = Mp.f - W.f;
+	uint32_t p1 = (uint32_t)(Mp.f >> -one.e);
+	uint64_t p2 = Mp.f & (one.f - 1);
+	int kappa = 10;
+	while (kappa > 1 && p1 < pow10_u32[kappa - 1])
+		--kappa;
+
+	int len = 0;
+	while (kappa > 0) {
+		uint32_t d = p1 / pow10_u32[kappa - 1];
+		p1 %= pow10_u32[kappa - 1];
+		if (d || len)
+			buf[len++] = (char)('0' + d);
+		--kappa;
+		uint64_t rest = ((uint64_t)p1 << -one.e) + p2;
+		if (rest <= delta) {
+			*K += kappa;
+			grisu_round(buf, len, delta, rest, pow10_u64[kappa] << -one.e, wp_w);
+			return len;
+		}
+	}
+
+	for (;;) {
+		p2 *= 10;
+		delta *= 10;
+		char d = (char)(p2 >> -one.e);
+		if (d || len)
+			buf[len++] = '0' + d;
+		p2 &= one.f - 1;
+		--kappa;
+		if (p2 < delta) {
+			*K += kappa;
+			grisu_round(buf, len, delta, p2, one.f, wp_w * (-kappa < 20 ? pow10_u64[-kappa] : 0));
+			return len;
+		}
+	}
+}
+
+/* ------------------------------------------------------------------------ */
+/* digits of positive finite non zero double and *K so that value = digits * 10^K */
+static int grisu2(uint64_t bits, char *buf, int *K)
+{
+	int biased_e = (int)(bits >> 52);
+	diy_fp_t v = { bits & (DP_HIDDEN_BIT - 1), -1074 };
+	if (biased_e) {
+		v.f += DP_HIDDEN_BIT;
+		v.e = biased_e - 1075;
+	}
+
+	/* boundaries m+ and m- in the middle between v and its neighbours */
+	diy_fp_t mp = diy_normalize((diy_fp_t){ (v.f << 1) + 1, v.e - 1 });
+	diy_fp_t mm = v.f == DP_HIDDEN_BIT ? (diy_fp_t){ (v.f << 2) - 1, v.e - 2 } : (diy_fp_t){ (v.f << 1) - 1, v.e - 1 };
+	mm.f <<= mm.e - mp.e;
+	mm.e = mp.e;
+
+	diy_fp_t c_mk = cached_power(mp.e, K);
+	diy_fp_t W = diy_multiply(diy_normalize(v), c_mk);
+	diy_fp_t Wp = diy_multiply(mp, c_mk);
+	diy_fp_t Wm = diy_multiply(mm, c_mk);
+	++Wm.f;
+	--Wp.f;
+	return digit_gen(W, Wp, Wp.f - Wm.f, buf, K);
+}
+
+/* ------------------------------------------------------------------------ */
+/* ECMAScript like layout of digits * 10^k: 12.34, 0.001234, 1234.0, 1.234e33, 1e-7 */
+static char *float_format(char *p, char const *digits, int len, int k)
+{
+	int kk = len + k; /* 10^(kk-1) <= value < 10^kk */
+	if (0 <= k && kk <= 21) {
+		memcpy(p, digits, (size_t)len);
+		memset(p + len, '0', (size_t)k);
+		p += kk;
+		*p++ = '.';
+		*p++ = '0';
+	} else if (0 < kk && kk <= 21) {
+		memcpy(p, digits, (size_t)kk);
+		p[kk] = '.';
+		memcpy(p + kk + 1, digits + kk, (size_t)(len - kk));
+		p += len + 1;
+	} else if (-6 < kk && kk <= 0) {
+		*p++ = '0';
+		*p++ = '.';
+		memset(p, '0', (size_t)-kk);
+		memcpy(p - kk, digits, (size_t)len);
+		p += len - kk;
+	} else {
+		*p++ = digits[0];
+		if (len > 1) {
+			*p++ = '.';
+			memcpy(p, digits + 1, (size_t)(len - 1));
+			p += len - 1;
+		}
+		*p++ = 'e';
+		int x = kk - 1;
+		if (x < 0) {
+			*p++ = '-';
+			x = -x;
+		}
+		if (x >= 100)
+			*p++ = (char)('0' + x / 100);
+		if (x >= 10)
+			*p++ = (char)('0' + x / 10 % 10);
+		*p++ = (char)('0' + x % 10);
+	}
+	return p;
+}
+
 /* ------------------------------------------------------------------------ */
 char *float2str(char *p, char *e, double f)
 {
-	e = p + snprintf(p, (size_t)(e-p), JSN_FLOAT_FORMAT, f);
-	while (e[-1] == '0' && (('0' <= e[-2] && e[-2] <= '9') || e[-2] == '.'))
-		--e;
-	*e = 0;
-	return e;
+	uint64_t bits;
+	memcpy(&bits, &f, sizeof bits);
+
+	char buf[32], *s = buf; /* -0.00000 + 17 digits or - + 21 digits + .0 */
+	if ((bits >> 52 & 0x7FF) == 0x7FF) { /* NaN and Infinity are not in JSON */
+		memcpy(s, "null", 4);
+		s += 4;
+	} else {
+		if (bits >> 63)
+			*s++ = '-';
+		bits &= ~((uint64_t)1 << 63);
+		if (!bits) {
+			memcpy(s, "0.0", 3);
+			s += 3;
+		} else {
+			char digits[20];
+			int K;
+			int len = grisu2(bits, digits, &K);
+			s = float_format(s, digits, len, K);
+		}
+	}
+
+	return str2buf(p, e, buf, (size_t)(s - buf));
 }
 #endif
 
+#ifdef JSON_LAZY_UNESCAPE
+
+/* ------------------------------------------------------------------------ */
+char *json_unescaped_id(jsn_t *node)
+{
+	if (node->escaped & JSN_ESCAPED_ID) { /* the parser marks nodes with escaped strings */
+		string_unescape(node->id.string, node->id.string);
+		node->escaped &= ~JSN_ESCAPED_ID;
+	}
+	return node->id.string;
+}
+
+
+/* ------------------------------------------------------------------------ */
+char *json_unescaped_string(jsn_t *node)
+{
+	if (node->escaped & JSN_ESCAPED_STRING) {
+		string_unescape(node->data.string, node->data.string);
+		node->escaped &= ~JSN_ESCAPED_STRING;
+	}
+	return node->data.string;
+}
+
+#endif
+
+/* ------------------------------------------------------------------------ */
+char const *json_id(jsn_t *node)
+{
+	return node && node->id_type == JS_STRING ? json_unescaped_id(node) : NULL;
+}
+
+
 /* ------------------------------------------------------------------------ */
 char const *json_string(jsn_t *node, char const *absent)
+{
+	if (node && (node->type == JS_NUMBER || node->type == JS_FLOAT))
+		return json_string_r(node, get_number_string_buffer(), NSB_LENGTH, absent);
+	return json_string_r(node, NULL, 0, absent);
+}
+
+
+/* ------------------------------------------------------------------------ */
+char const *json_string_r(jsn_t *node, char *buf, size_t size, char const *absent)
 {
 	if (!node)
 		return absent;
@@ -182,22 +674,20 @@ char const *json_string(jsn_t *node, char const *absent)
 	case JS_BOOLEAN:
 		return node->data.number ? "true" : "false";
 
-	case JS_NUMBER: {
-			char *buf = get_number_string_buffer();
-			snprintf(buf, NSB_LENGTH, JSN_NUMBER_FORMAT, node->data.number);
-			return buf;
-		}
+	case JS_NUMBER:
+		if (number2str(buf, buf + size, node->data.number) >= buf + size)
+			return errno = ENOBUFS, absent;
+		return buf;
 
 #ifdef JSON_FLOATS
-	case JS_FLOAT: {
-			char *buf = get_number_string_buffer();
-			float2str(buf, buf + NSB_LENGTH, node->data.floating);
-			return buf;
-		}
+	case JS_FLOAT:
+		if (float2str(buf, buf + size, node->data.floating) >= buf + size)
+			return errno = ENOBUFS, absent;
+		return buf;
 #endif
 
 	case JS_STRING:
-		return node->data.string;
+		return json_unescaped_string(node);
 
 	case JS_ARRAY:
 		return "[object Array]";
@@ -6,9 +6,16 @@
 #include "stdarg.h"
 #include "string.h"
 #include "errno.h"
+#include "locale.h"
+#include "time.h"
 
 #include "nano/json.h"
 
+#ifdef JSON_NDJSON_FN
+#include "unistd.h"
+#include "pthread.h"
+#endif
+
 /*
 
 FALSE    false
@@ -32,18 +39,116 @@ json     object | array | TRUE | FALSE | NULL | number | string
 typedef
 struct jsn_parser jsn_parser_t;
 
+#ifdef JSON_TWO_STAGE
+/* ------------------------------------------------------------------------ */
+typedef
+struct jsn_masks {
+	uint64_t quote;     /* '"'                  */
+	uint64_t backslash; /* '\\'                 */
+	uint64_t op;        /* '{', '}', '[', ']', ':', ',' */
+	uint64_t space;     /* ' ', '\t', '\r', '\n'  */
+	uint64_t zero;      /* terminating zero     */
+} jsn_masks_t;
+
+/* ------------------------------------------------------------------------ */
+typedef
+struct jsn_index {
+	char const *text;  /* the indexed text */
+	char const *end;   /* its terminating zero */
+	char const *block; /* current 64 bytes aligned block of text */
+	char const *zero;  /* terminating zero position (if found) */
+	uint64_t tokens;   /* structural chars, quotes and scalar starts of the block */
+	uint64_t escaped;  /* 1 if the first char of next block is escaped */
+	uint64_t string;   /* ~0 if next block starts inside of string */
+	uint64_t boundary; /* 1 if last char of block is space, quote or op */
+} jsn_index_t;
+#endif
+
 /* ------------------------------------------------------------------------ */
 struct jsn_parser {
 	char *text;       /* source text */
 	char *ptr;        /* current parser position */
+#ifdef JSON_TWO_STAGE
+	jsn_index_t index;
+#endif
 
 	jsn_t *pool;            /* array of json nodes */
 	size_t free_node_index; /* index of first free node */
+	size_t root_index;      /* index of the document root (next documents of one pool) */
 	size_t pool_size;       /* total array size */
 
 	jsn_t *(* alloc)(jsn_parser_t *p);
+#ifdef JSON_PARSE_N_FN
+	char *end;         /* end of text of length bounded parsing (NULL - zero terminated text) */
+	char *strings;     /* free space of separate buffer of unescaped strings */
+	char *strings_end; /* end of the strings buffer (NULL - the buffer is overflowed) */
+#endif
+#ifdef JSON_LAZY_UNESCAPE
+	int lazy;          /* terminate strings in text while matching */
+#endif
+#ifdef JSON_PARSE_NEXT_FN
+	int concatenated;  /* other documents may follow the parsed one */
+#endif
+#ifdef JSON_SAX_FN
+	jsn_handlers_t const *handlers;
+	void *ctx;
+#endif
+#ifdef JSON_STATS
+	jsn_stats_t *stats; /* NULL - not collected */
+	uint64_t lap;       /* start time of current phase */
+#endif
 };
 
+#ifdef JSON_STATS
+
+static __thread jsn_stats_t *stats_collector; /* stats of next parsings of the thread set by json_stats() */
+
+/* runs the hook if the parser collects stats, removed without JSON_STATS */
+#define STATS(p, ...) \
+	do { if ((p)->stats) { __VA_ARGS__; } } while (0)
+
+/* ------------------------------------------------------------------------ */
+static void stats_lap(jsn_parser_t *p, uint64_t *phase)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	uint64_t now = (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+	if (phase)
+		*phase += now - p->lap;
+	p->lap = now;
+}
+
+
+/* ------------------------------------------------------------------------ */
+static void stats_done(jsn_parser_t *p, int result)
+{
+	jsn_stats_t *s = p->stats;
+	++s->parses;
+	if (result <= 0)
+		++s->failures;
+	else
+		if ((int)(p->free_node_index - p->root_index) > s->max_nodes)
+			s->max_nodes = p->free_node_index - p->root_index;
+	if (s->hook)
+		s->hook(s, result);
+}
+
+
+/* ------------------------------------------------------------------------ */
+jsn_stats_t *json_stats(jsn_stats_t *stats)
+{
+	jsn_stats_t *prev = stats_collector;
+	stats_collector = stats;
+	return prev;
+}
+
+#else
+
+#define STATS(p, ...) \
+	do {} while (0)
+
+#endif
+
 
 /* ------------------------------------------------------------------------ */
 static int is_alpha_char(int c)
@@ -58,83 +163,204 @@ static int is_id_char(int c)
 	if (c < 'A')
 		return '0' <= c && c <= '9';
 	if (c >= 'a')
-		return c <= 'z' || c == '_';
-	return c <= 'Z';
+		return c <= 'z';
+	return c <= 'Z' || c == '_';
 }
 
 
 /* ------------------------------------------------------------------------ */
-static int after_space(char **p)
+static int is_space(int ch)
 {
-	char *s = *p;
-	for (uint32_t ch; ch = *s, ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n'; ++s)
-		;
+	return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n';
+}
 
-	return *(*p = s);
+
+/* ------------------------------------------------------------------------ */
+static int is_string_special(int ch)
+{
+	return ch == '"' || ch == '\\' || (unsigned char)ch < ' ';
 }
 
 
+/* ------------------------------------------------------------------------ */
+static char const *string_scan_scalar(char const *s)
+{
+	while (!is_string_special(*s))
+		++s;
+	return s;
+}
+
 
 /* ------------------------------------------------------------------------ */
-static int match_char(char **p, int ch)
+static char const *space_scan_scalar(char const *s)
 {
-	return after_space(p) == ch ? (++*p, 1) : 0;
+	while (is_space(*s))
+		++s;
+	return s;
 }
 
+
+#if defined(JSON_SIMD) && (defined(__x86_64__) || defined(__i386__))
+
+#include "immintrin.h"
+
+/*
+	Vector scanners never read before `s`. The first block is loaded from `s`
+	unless it crosses a page (then the head up to the aligned block is scanned
+	by chars), the next ones are aligned, so no block crosses a page boundary.
+	The block of the terminating zero is read whole: up to width - 1 bytes after
+	the zero are looked at and ignored. That is not an error on any x86 memory
+	but it is out of the C object, so the scanners are not instrumented by ASan.
+*/
+
+#define SCAN_PAGE_SIZE 4096 /* the smallest x86 page */
+
 /* ------------------------------------------------------------------------ */
-int match_number(char **p, jsn_t *obj)
+__attribute__((target("sse2"), no_sanitize_address))
+static unsigned int string_mask_sse2(char const *p)
 {
-	char *s = *p;
-	char *c = s;
-	if (*c == '-')
-		++c;
-#ifndef JSON_HEX_NUMBERS
-	if (c[0] == '0' && (c[1] == 'x' || c[1] == 'X'))
-		return 0;
-#endif
-	while ('0' <= *c && *c <= '9')
-		++c;
-#ifdef JSON_FLOATS
-	if (*c == '.' || *c == 'E' || *c == 'e') {
-		obj->data.floating = strtod(s, p);
-		if (s == *p)
-			return 0;
-		return obj->type = JS_FLOAT;
-	}
-#endif
-#ifdef JSON_64BITS_INTEGERS
-#if LLONG_MAX == INT64_MAX
-	obj->data.number = strtoll(s, p, 0);
-#else
-#if LONG_MAX == INT64_MAX
-	obj->data.number = strtol(s, p, 0);
-#else
-	#error "impossible to choose of 64 bits strtol function"
-#endif
-#endif
-#else
-#if LLONG_MAX == INT32_MAX
-	obj->data.number = strtoll(s, p, 0);
-#else
-#if LONG_MAX == INT32_MAX
-	obj->data.number = strtol(s, p, 0);
-#else
-#if LONG_MAX > INT32_MAX
-	long l = strtol(s, p, 0);
-	if (l > INT32_MAX) l = INT32_MAX;
-	else if (l < INT32_MIN) l = INT32_MIN;
-	obj->data.number = l;
+	__m128i v = _mm_loadu_si128((__m128i const *)p);
+	__m128i m = _mm_or_si128(
+		_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))),
+		_mm_cmpeq_epi8(_mm_min_epu8(v, _mm_set1_epi8(0x1F)), v));
+	return (unsigned int)_mm_movemask_epi8(m);
+}
+
+
+/* ------------------------------------------------------------------------ */
+__attribute__((target("sse2"), no_sanitize_address))
+static unsigned int space_mask_sse2(char const *p)
+{
+	__m128i v = _mm_loadu_si128((__m128i const *)p);
+	__m128i m = _mm_or_si128(
+		_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+		_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\r')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))));
+	return ~(unsigned int)_mm_movemask_epi8(m) & 0xFFFF;
+}
+
+
+/* ------------------------------------------------------------------------ */
+__attribute__((target("avx2"), no_sanitize_address))
+static unsigned int string_mask_avx2(char const *p)
+{
+	__m256i v = _mm256_loadu_si256((__m256i const *)p);
+	__m256i m = _mm256_or_si256(
+		_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'))),
+		_mm256_cmpeq_epi8(_mm256_min_epu8(v, _mm256_set1_epi8(0x1F)), v));
+	return (unsigned int)_mm256_movemask_epi8(m);
+}
+
+
+/* ------------------------------------------------------------------------ */
+__attribute__((target("avx2"), no_sanitize_address))
+static unsigned int space_mask_avx2(char const *p)
+{
+	__m256i v = _mm256_loadu_si256((__m256i const *)p);
+	__m256i m = _mm256_or_si256(
+		_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'))),
+		_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'))));
+	return ~(unsigned int)_mm256_movemask_epi8(m);
+}
+
+
+#define DEFINE_SCANNER(name, mask, stop, width, arch) \
+__attribute__((target(arch), no_sanitize_address)) \
+static char const *name(char const *s) \
+{ \
+	unsigned int m; \
+	if (((uintptr_t)s & (SCAN_PAGE_SIZE - 1)) <= SCAN_PAGE_SIZE - width) { \
+		if ((m = mask(s))) \
+			return s + __builtin_ctz(m); \
+		s = (char const *)(((uintptr_t)s | (width - 1)) + 1); \
+	} else \
+		for (; (uintptr_t)s & (width - 1); ++s) \
+			if (stop(*s)) \
+				return s; \
+	while (!(m = mask(s))) \
+		s += width; \
+	return s + __builtin_ctz(m); \
+}
+
+DEFINE_SCANNER(string_scan_sse2, string_mask_sse2, is_string_special, 16, "sse2")
+DEFINE_SCANNER(space_scan_sse2,  space_mask_sse2,  !is_space,         16, "sse2")
+DEFINE_SCANNER(string_scan_avx2, string_mask_avx2, is_string_special, 32, "avx2")
+DEFINE_SCANNER(space_scan_avx2,  space_mask_avx2,  !is_space,         32, "avx2")
+
+
+static char const *string_scan_init(char const *s);
+static char const *space_scan_init(char const *s);
+
+static char const *(*string_scan_fn)(char const *s) = string_scan_init;
+static char const *(*space_scan_fn)(char const *s) = space_scan_init;
+
+/* ------------------------------------------------------------------------ */
+/* at load time, so threads only read the pointers (lazy init is left for calls of other constructors) */
+__attribute__((constructor))
+static void scanners_init(void)
+{
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		string_scan_fn = string_scan_avx2;
+		space_scan_fn = space_scan_avx2;
+	} else
+		if (__builtin_cpu_supports("sse2")) {
+			string_scan_fn = string_scan_sse2;
+			space_scan_fn = space_scan_sse2;
+		} else {
+			string_scan_fn = string_scan_scalar;
+			space_scan_fn = space_scan_scalar;
+		}
+}
+
+
+/* ------------------------------------------------------------------------ */
+static char const *string_scan_init(char const *s)
+{
+	scanners_init();
+	return string_scan_fn(s);
+}
+
+
+/* ------------------------------------------------------------------------ */
+static char const *space_scan_init(char const *s)
+{
+	scanners_init();
+	return space_scan_fn(s);
+}
+
 #else
-	#error "impossible to choose of 32 bits strtol function"
-#endif
-#endif
-#endif
+
+#define string_scan_fn string_scan_scalar
+#define space_scan_fn  space_scan_scalar
+
 #endif
 
-	return *p == s ? 0 : (obj->type = JS_NUMBER);
+
+/* ------------------------------------------------------------------------ */
+char const *string_scan(char const *s)
+{
+	return string_scan_fn(s);
+}
+
+
+/* ------------------------------------------------------------------------ */
+static int after_space(char **p)
+{
+	char *s = *p;
+	if (is_space(*s))
+		s = (char *)(is_space(s[1]) ? space_scan_fn(s + 1) : s + 1);
+
+	return *(*p = s);
 }
 
 
+
+/* ------------------------------------------------------------------------ */
+static int match_char(char **p, int ch)
+{
+	return after_space(p) == ch ? (++*p, 1) : 0;
+}
+
 /* ------------------------------------------------------------------------ */
 static int hextonibble(char digit)
 {
@@ -153,9 +379,185 @@ static int hextonibble(char digit)
 }
 
 
+#ifdef JSON_64BITS_INTEGERS
+#define JSN_NUMBER_MAX INT64_MAX
+#else
+#define JSN_NUMBER_MAX INT32_MAX
+#endif
+
+#if defined(JSON_FLOATS) && defined(JSON_FAST_FLOATS)
+/* ------------------------------------------------------------------------ */
+static double const exact_pow10[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+#define EXACT_MANTISSA_MAX ((uint64_t)1 << 53)
+
+/* ------------------------------------------------------------------------ */
+/* Clinger's fast path: a mantissa and a power of ten both exactly representable
+   by double give the correctly rounded result by a single multiplication or
+   division. Returns NULL for the numbers out of the path. */
+static char *match_fast_float(char *s, double *d)
+{
+	char *c = s;
+	int negative = *c == '-';
+	if (*c == '-' || *c == '+')
+		++c;
+
+	uint64_t m = 0;
+	int digits = 0, exp = 0, truncated = 0;
+	char *start = c;
+	while (*c == '0')
+		++c;
+	for (unsigned int n; (n = (unsigned char)*c - '0') < 10; ++c)
+		if (digits < 19)
+			m = m * 10 + n, ++digits;
+		else
+			++exp, truncated = 1;
+
+	int any = c != start;
+	if (*c == '.') {
+		start = ++c;
+		if (!m)
+			for (; *c == '0'; ++c)
+				--exp;
+		for (unsigned int n; (n = (unsigned char)*c - '0') < 10; ++c)
+			if (digits < 19)
+				m = m * 10 + n, ++digits, --exp;
+			else
+				truncated = 1;
+		any |= c != start;
+	}
+	if (!any)
+		return NULL;
+
+	if (*c == 'e' || *c == 'E') {
+		char *e = c + 1;
+		int negative_exp = *e == '-';
+		if (*e == '-' || *e == '+')
+			++e;
+		if ((unsigned char)*e - '0' >= 10)
+			return NULL;
+		int x = 0;
+		for (unsigned int n; (n = (unsigned char)*e - '0') < 10; ++e)
+			if (x < 10000)
+				x = x * 10 + n;
+		exp += negative_exp ? -x : x;
+		c = e;
+	}
+
+	if (truncated || m > EXACT_MANTISSA_MAX)
+		return NULL;
+
+	double v = (double)m;
+	if (!m)
+		;
+	else if (exp < 0) {
+		if (exp < -22)
+			return NULL;
+		v /= exact_pow10[-exp];
+	} else if (exp <= 22)
+		v *= exact_pow10[exp];
+	else {
+		/* 1.5e25 -> 15000000 * 1e22 while the mantissa is still exact */
+		for (; exp > 22; --exp)
+			if ((m *= 10) > EXACT_MANTISSA_MAX)
+				return NULL;
+		v = (double)m * exact_pow10[22];
+	}
+	*d = negative ? -v : v;
+	return c;
+}
+
+/* ------------------------------------------------------------------------ */
+static double strtod_c(char const *s, char **end)
+{
+	static locale_t c_locale; /* created once, a thread losing the race frees its own */
+	locale_t c = __atomic_load_n(&c_locale, __ATOMIC_ACQUIRE);
+	if (!c) {
+		locale_t created = newlocale(LC_ALL_MASK, "C", (locale_t)0);
+		if (created && !__atomic_compare_exchange_n(&c_locale, &c, created, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+			freelocale(created); /* c is the winner one */
+		else
+			c = created;
+	}
+	return c ? strtod_l(s, end, c) : strtod(s, end);
+}
+#endif
+
+/* ------------------------------------------------------------------------ */
+int match_number(char **p, jsn_t *obj)
+{
+	char *s = *p;
+	char *c = s;
+	int negative = *c == '-';
+	if (*c == '-' || *c == '+')
+		++c;
+
+	uint64_t v = 0;
+	int overflow = 0;
+	char *digits = c;
+	if (c[0] == '0' && (c[1] == 'x' || c[1] == 'X')) {
+#ifdef JSON_HEX_NUMBERS
+		digits = c += 2;
+		while (*c == '0')
+			++c;
+		char *first = c;
+		for (unsigned int d; (d = hextonibble(*c)) < 16; ++c)
+			v = v << 4 | d;
+		overflow = c - first > 16;
+#else
+		return 0;
+#endif
+	} else {
+		while (*c == '0')
+			++c;
+		char *first = c;
+		for (unsigned int d; (d = (unsigned char)*c - '0') < 10; ++c)
+			v = v * 10 + d; /* 19 digits can not overflow 64 bits */
+		overflow = c - first > 19;
+#ifdef JSON_FLOATS
+		if (*c == '.' || *c == 'E' || *c == 'e') {
+#ifdef JSON_FAST_FLOATS
+			double f; /* data of packed node may be unaligned */
+			char *end = match_fast_float(s, &f);
+			if (end) {
+				obj->data.floating = f;
+				*p = end;
+				return obj->type = JS_FLOAT;
+			}
+			obj->data.floating = strtod_c(s, p);
+#else
+			obj->data.floating = strtod(s, p);
+#endif
+			if (s == *p)
+				return 0;
+			return obj->type = JS_FLOAT;
+		}
+#endif
+	}
+	if (c == digits)
+		return 0;
+
+	/* clamp like strtol() */
+	uint64_t limit = (uint64_t)JSN_NUMBER_MAX + negative;
+	if (overflow || v > limit)
+		v = limit;
+	obj->data.number = (jsn_number_t)(negative ? 0 - v : v);
+	*p = c;
+	return obj->type = JS_NUMBER;
+}
+
+
 /* ------------------------------------------------------------------------ */
 int string_unescape(char *d, char *s)
 {
+	if (d == s) { /* skip in place a head without escapes */
+		while (s = (char *)string_scan_fn(s), *s && *s != '"' && *s != '\\')
+			++s;
+		d = s;
+	}
 	for (; *s && *s != '"'; ++s) {
 		if (*s == '\\') {
 			switch (*++s) {
@@ -211,7 +613,9 @@ static int match_string(char **p, char **str)
 	if (*s != '"')
 		return 0;
 
-	for (++s; *s && *s != '"'; ++s) {
+	for (++s; *(s = (char *)string_scan_fn(s)) != '"'; ++s) {
+		if (!*s)
+			return 0;
 		if (*s == '\\') {
 			switch (*++s) {
 			case '"':
@@ -223,224 +627,1640 @@ static int match_string(char **p, char **str)
 			case 'r':
 			case 't':
 				break;
-			case 'u': {
-					for (int i = 1; i < 5; ++i) {
-						uint32_t d = hextonibble(s[i]);
-						if (d > 15) {
-							--s;
-							goto _not_escape;
-						}
-					}
-					s += 4;
-				} break;
+			case 'u':
+				for (int i = 1; i < 5; ++i)
+					if (hextonibble(s[i]) > 15)
+						goto _not_escape;
+				s += 4;
+				break;
 			default:
+_not_escape:
 				--s;
-				goto _not_escape;
 			}
-		} else
-_not_escape:;
-	}
-	if (*s == '"') {
-		*str = *p + 1;
-		*p = s + 1;
-		return 1;
+		}
 	}
-	return 0;
+	*str = *p + 1;
+	*p = s + 1;
+	return 1;
 }
 
 
-/* ------------------------------------------------------------------------ */
-static int match_json(jsn_parser_t *p, jsn_t *obj)
-{
-	int open_char = after_space(&p->ptr);
-	if (open_char != '[' && open_char != '{' ) {
-		char *s = p->ptr;
-		switch (open_char) {
-		case '"':
-			if (!match_string(&p->ptr, &obj->data.string))
-				return errno = EINVAL, 0;
-			return obj->type = JS_STRING;
-		case 'n':
-			if (s[1] != 'u' || s[2] != 'l' || s[3] != 'l' || is_id_char(s[4]))
-				return errno = EINVAL, 0;
-			p->ptr = s + 4;
-			return obj->type = JS_NULL;
-		case 't':
-			if (s[1] != 'r' || s[2] != 'u' || s[3] != 'e' || is_id_char(s[4]))
-				return errno = EINVAL, 0;
-			p->ptr = s + 4;
-			obj->data.number = 1;
-			return obj->type = JS_BOOLEAN;
-		case 'f':
-			if (s[1] != 'a' || s[2] != 'l' || s[3] != 's'  || s[4] != 'e' || is_id_char(s[5]))
-				return errno = EINVAL, 0;
-			p->ptr = s + 5;
-			obj->data.number = 0;
-			return obj->type = JS_BOOLEAN;
-		default:
-			return match_number(&p->ptr, obj) ?: ( errno = EINVAL, 0);
-		}
-	}
+#ifdef JSON_PARSE_N_FN
 
-	p->ptr += 1;
+/*
+	Length bounded parsing never reads text after the end and never writes
+	to the text: strings are unescaped to the separate buffer right after
+	matching and numbers/literals are matched in a zero terminated copy.
+*/
 
-	int is_object = open_char == '{';
-	int close_char = is_object ? '}' : ']';
+/* ------------------------------------------------------------------------ */
+static int skip_space_n(jsn_parser_t *p)
+{
+	char *s = p->ptr;
+	while (s < p->end && is_space(*s))
+		++s;
+	p->ptr = s;
+	return s < p->end ? *s : 0;
+}
 
-	int index = 0;
 
-	if (match_char(&p->ptr, close_char))
-		goto _empty;
+/* ------------------------------------------------------------------------ */
+static int match_text_n(jsn_parser_t *p, char **str)
+{
+	char *s = p->ptr, *e = p->end;
+	if (s >= e || *s != '"')
+		return 0;
 
-	int prev_ofs = obj - p->pool;
-	int obj_ofs = obj - p->pool;
-	do {
-		jsn_t *node = p->alloc(p);
-		if (!node)
+	for (++s; s < e && *s != '"'; ++s) {
+		if (!*s)
 			return 0;
+		if (*s == '\\' && s + 1 < e && (s[1] == '"' || s[1] == '\\'))
+			++s;
+	}
+	if (s >= e)
+		return 0;
 
-		int node_ofs = (int)(node - p->pool);
-		if (obj_ofs != prev_ofs)
-			p->pool[prev_ofs].next = node_ofs - obj_ofs;
-		prev_ofs = node_ofs;
+	if (p->strings_end - p->strings < s - p->ptr) { /* unescaped string is not longer */
+		p->strings_end = NULL;
+		return 0;
+	}
 
-		after_space(&p->ptr);
-		if (is_object) {
-			if (!match_string(&p->ptr, &node->id.string))
-				return errno = EINVAL, 0;
-			node->id_type = JS_STRING;
-			if (!match_char(&p->ptr, ':'))
-				return errno = EINVAL, 0;
-		} else {
-			node->id.number = index;
-			node->id_type = JS_NUMBER;
-		}
+	string_unescape(p->strings, p->ptr + 1);
+	*str = p->strings;
+	p->strings += strlen(p->strings) + 1;
+	p->ptr = s + 1;
+	return 1;
+}
 
-		if (!match_json(p, node))
-			return 0;
+#endif
 
-		++index;
-	} while (match_char(&p->ptr, ','));
+#ifdef JSON_TWO_STAGE
 
-	if (!match_char(&p->ptr,  close_char))
-		return errno = EINVAL, 0;
+/*
+	Stage 1 classifies text by 64 bytes blocks into bitmaps of structural chars,
+	string quotes and starts of scalars (numbers and literals). Stage 2 is the
+	match_json() which jumps by the bitmaps over spaces and strings bodies
+	instead of scanning them char by char. Blocks are indexed on demand, so the
+	index takes no memory but the jsn_parser_t itself. Only blocks inside of the
+	text are read in place: the first and the last ones are copied to a zero
+	padded block, so nothing before the text or after its zero is read.
+*/
 
-	obj = p->pool + obj_ofs;
+/* ------------------------------------------------------------------------ */
+static void block_masks_scalar(char const *p, jsn_masks_t *m)
+{
+	static uint8_t const classes[256] = {
+		[0] = 16,
+		['{'] = 1, ['}'] = 1, ['['] = 1, [']'] = 1, [':'] = 1, [','] = 1,
+		[' '] = 2, ['\t'] = 2, ['\r'] = 2, ['\n'] = 2,
+		['"'] = 4, ['\\'] = 8
+	};
+
+	uint64_t op = 0, space = 0, quote = 0, backslash = 0, zero = 0;
+	for (int i = 0; i < 64; ++i) {
+		uint64_t c = classes[(unsigned char)p[i]];
+		op        |= (c      & 1) << i;
+		space     |= (c >> 1 & 1) << i;
+		quote     |= (c >> 2 & 1) << i;
+		backslash |= (c >> 3 & 1) << i;
+		zero      |= (c >> 4 & 1) << i;
+	}
+	m->op = op;
+	m->space = space;
+	m->quote = quote;
+	m->backslash = backslash;
+	m->zero = zero;
+}
+
+
+#if defined(JSON_SIMD) && (defined(__x86_64__) || defined(__i386__))
+
+/* ------------------------------------------------------------------------ */
+__attribute__((target("sse2")))
+static uint64_t eq_mask_sse2(__m128i const v[4], char ch)
+{
+	__m128i c = _mm_set1_epi8(ch);
+	uint64_t m = 0;
+	for (int i = 0; i < 4; ++i)
+		m |= (uint64_t)(unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(v[i], c)) << 16 * i;
+	return m;
+}
+
+
+/* ------------------------------------------------------------------------ */
+__attribute__((target("sse2")))
+static void block_masks_sse2(char const *p, jsn_masks_t *m)
+{
+	__m128i v[4];
+	for (int i = 0; i < 4; ++i)
+		v[i] = _mm_load_si128((__m128i const *)p + i);
+
+	m->op = eq_mask_sse2(v, '{') | eq_mask_sse2(v, '}') | eq_mask_sse2(v, '[')
+	      | eq_mask_sse2(v, ']') | eq_mask_sse2(v, ':') | eq_mask_sse2(v, ',');
+	m->space = eq_mask_sse2(v, ' ') | eq_mask_sse2(v, '\t') | eq_mask_sse2(v, '\r') | eq_mask_sse2(v, '\n');
+	m->quote = eq_mask_sse2(v, '"');
+	m->backslash = eq_mask_sse2(v, '\\');
+	m->zero = eq_mask_sse2(v, 0);
+}
+
+
+/* ------------------------------------------------------------------------ */
+__attribute__((target("avx2")))
+static uint64_t eq_mask_avx2(__m256i const v[2], char ch)
+{
+	__m256i c = _mm256_set1_epi8(ch);
+	return (uint64_t)(unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v[0], c))
+	     | (uint64_t)(unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v[1], c)) << 32;
+}
+
+
+/* ------------------------------------------------------------------------ */
+__attribute__((target("avx2")))
+static void block_masks_avx2(char const *p, jsn_masks_t *m)
+{
+	__m256i v[2] = {
+		_mm256_load_si256((__m256i const *)p),
+		_mm256_load_si256((__m256i const *)p + 1)
+	};
+
+	m->op = eq_mask_avx2(v, '{') | eq_mask_avx2(v, '}') | eq_mask_avx2(v, '[')
+	      | eq_mask_avx2(v, ']') | eq_mask_avx2(v, ':') | eq_mask_avx2(v, ',');
+	m->space = eq_mask_avx2(v, ' ') | eq_mask_avx2(v, '\t') | eq_mask_avx2(v, '\r') | eq_mask_avx2(v, '\n');
+	m->quote = eq_mask_avx2(v, '"');
+	m->backslash = eq_mask_avx2(v, '\\');
+	m->zero = eq_mask_avx2(v, 0);
+}
+
+
+static void block_masks_init(char const *p, jsn_masks_t *m);
+
+static void (*block_masks_fn)(char const *p, jsn_masks_t *m) = block_masks_init;
+
+/* ------------------------------------------------------------------------ */
+/* at load time like scanners_init() */
+__attribute__((constructor))
+static void block_masks_select(void)
+{
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		block_masks_fn = block_masks_avx2;
+	else
+		if (__builtin_cpu_supports("sse2"))
+			block_masks_fn = block_masks_sse2;
+		else
+			block_masks_fn = block_masks_scalar;
+}
+
+
+/* ------------------------------------------------------------------------ */
+static void block_masks_init(char const *p, jsn_masks_t *m)
+{
+	block_masks_select();
+	block_masks_fn(p, m);
+}
+
+#else
+
+#define block_masks_fn block_masks_scalar
+
+#endif
+
+
+/* ------------------------------------------------------------------------ */
+static uint64_t prefix_xor(uint64_t x)
+{
+	x ^= x << 1;
+	x ^= x << 2;
+	x ^= x << 4;
+	x ^= x << 8;
+	x ^= x << 16;
+	x ^= x << 32;
+	return x;
+}
+
+
+/* ------------------------------------------------------------------------ */
+static uint64_t escaped_chars(uint64_t backslash, uint64_t *carry)
+{
+	uint64_t const even = 0x5555555555555555ull;
+
+	backslash &= ~*carry;
+	uint64_t follows = backslash << 1 | *carry;
+	uint64_t odd_starts = backslash & ~even & ~follows;
+	uint64_t even_starts = odd_starts + backslash;
+	*carry = even_starts < odd_starts;
+	return (even ^ even_starts << 1) & follows;
+}
+
+
+/* ------------------------------------------------------------------------ */
+static void index_block(jsn_index_t *x, char const *block, uint64_t lead)
+{
+	jsn_masks_t m;
+	if (block >= x->text && block + 64 <= x->end + 1)
+		block_masks_fn(block, &m);
+	else { /* the first and the last blocks are classified in a copy padded by zeros */
+		char copy[64] __attribute__((aligned(64))) = { 0 };
+		char const *s = block < x->text ? x->text : block, *e = block + 64 <= x->end + 1 ? block + 64 : x->end + 1;
+		memcpy(copy + (s - block), s, e - s);
+		block_masks_fn(copy, &m);
+	}
+
+	uint64_t valid = ~0ull, zero = m.zero & ~lead;
+	if (zero) {
+		valid = (zero & -zero) - 1;
+		x->zero = block + __builtin_ctzll(zero);
+	}
+
+	uint64_t space = m.space | lead;
+	uint64_t quote = m.quote & ~lead & ~escaped_chars(m.backslash & ~lead, &x->escaped);
+	uint64_t string = prefix_xor(quote) ^ x->string;
+	uint64_t op = m.op & ~string;
+	uint64_t boundary = space | op | quote;
+	uint64_t scalar = ~boundary & ~string & (boundary << 1 | x->boundary);
+
+	x->block = block;
+	x->tokens = (op | quote | scalar) & valid;
+	x->string = (uint64_t)((int64_t)string >> 63);
+	x->boundary = boundary >> 63;
+}
+
+
+/* ------------------------------------------------------------------------ */
+static void index_init(jsn_index_t *x, char const *text)
+{
+	char const *block = (char const *)((uintptr_t)text & ~(uintptr_t)63);
+	x->text = text;
+	x->end = text + strlen(text);
+	x->zero = NULL;
+	x->escaped = 0;
+	x->string = 0;
+	x->boundary = 1;
+	index_block(x, block, ((uint64_t)1 << (text - block)) - 1);
+}
+
+
+/* ------------------------------------------------------------------------ */
+static char *index_next(jsn_index_t *x, char const *s)
+{
+	for (;;) {
+		long ofs = s - x->block;
+		uint64_t tokens = ofs <= 0 ? x->tokens : ofs < 64 ? x->tokens & ~0ull << ofs : 0;
+		if (tokens)
+			return (char *)x->block + __builtin_ctzll(tokens);
+		if (x->zero)
+			return (char *)x->zero;
+		index_block(x, x->block + 64, 0);
+	}
+}
+
+
+/* ------------------------------------------------------------------------ */
+static int skip_space(jsn_parser_t *p)
+{
+#ifdef JSON_PARSE_N_FN
+	if (p->end)
+		return skip_space_n(p);
+#endif
+	if (is_space(*p->ptr))
+		p->ptr = index_next(&p->index, p->ptr);
+	return *p->ptr;
+}
+
+
+/* ------------------------------------------------------------------------ */
+static int match_text(jsn_parser_t *p, char **str)
+{
+#ifdef JSON_PARSE_N_FN
+	if (p->end)
+		return match_text_n(p, str);
+#endif
+	char *s = p->ptr;
+	if (*s != '"')
+		return 0;
+
+	char *e = index_next(&p->index, s + 1);
+	if (*e != '"')
+		return 0;
+
+	*str = s + 1;
+	p->ptr = e + 1;
+	return 1;
+}
+
+#else
+
+/* ------------------------------------------------------------------------ */
+static int skip_space(jsn_parser_t *p)
+{
+#ifdef JSON_PARSE_N_FN
+	if (p->end)
+		return skip_space_n(p);
+#endif
+	return after_space(&p->ptr);
+}
+
+
+/* ------------------------------------------------------------------------ */
+static int match_text(jsn_parser_t *p, char **str)
+{
+#ifdef JSON_PARSE_N_FN
+	if (p->end)
+		return match_text_n(p, str);
+#endif
+	return match_string(&p->ptr, str);
+}
+
+#endif
+
+
+/* ------------------------------------------------------------------------ */
+static int match_token(jsn_parser_t *p, int ch)
+{
+	return skip_space(p) == ch ? (++p->ptr, 1) : 0;
+}
+
+
+/* ------------------------------------------------------------------------ */
+/* match_text() of node string or id */
+static int match_node_text(jsn_parser_t *p, char **str)
+{
+#ifdef JSON_STATS
+	char const *quote = p->ptr;
+	if (!match_text(p, str))
+		return 0;
+	if (p->stats) {
+		size_t length = p->ptr - quote - 2;
+		p->stats->string_bytes += length;
+		++p->stats->strings;
+		if (memchr(quote + 1, '\\', length))
+			++p->stats->escaped;
+	}
+	return 1;
+#else
+	return match_text(p, str);
+#endif
+}
+
+
+#ifdef JSON_LAZY_UNESCAPE
+
+/*
+	Strings are zero terminated in place of closing quotes right after matching
+	and nodes of escaped ones are marked by JSN_ESCAPED_* flags. They are
+	unescaped by json_unescaped_id()/json_unescaped_string() at first access.
+*/
+
+/* ------------------------------------------------------------------------ */
+static int lazy_string(jsn_parser_t *p, char *s, int flag)
+{
+	char *e = p->ptr - 1; /* closing quote */
+	*e = 0;
+	return memchr(s, '\\', e - s) ? flag : 0;
+}
+
+
+/* ------------------------------------------------------------------------ */
+static void lazy_restore(jsn_parser_t *p)
+{
+	for (size_t i = p->root_index; i < p->free_node_index; ++i) {
+		jsn_t *node = p->pool + i;
+		if (node->type == JS_STRING)
+			node->data.string[strlen(node->data.string)] = '"';
+		if (node->id_type == JS_STRING)
+			node->id.string[strlen(node->id.string)] = '"';
+	}
+}
+
+#endif
+
+/* ------------------------------------------------------------------------ */
+static int match_scalar(jsn_parser_t *p, jsn_t *obj, int first_char)
+{
+#ifdef JSON_PARSE_N_FN
+	if (p->end && first_char != '"') { /* match a zero terminated copy of number or literal */
+		char *e = p->ptr;
+		while (e < p->end && (is_id_char(*e) || *e == '-' || *e == '+' || *e == '.'))
+			++e;
+		size_t n = e - p->ptr;
+		char stack_buf[128], *buf = n < sizeof stack_buf ? stack_buf : malloc(n + 1);
+		if (!buf)
+			return 0;
+		memcpy(buf, p->ptr, n);
+		buf[n] = 0;
+
+		jsn_parser_t q = { .text = buf, .ptr = buf };
+		int type = match_scalar(&q, obj, first_char);
+		p->ptr += q.ptr - buf;
+		if (buf != stack_buf)
+			free(buf);
+		return type;
+	}
+#endif
+	char *s = p->ptr;
+	switch (first_char) {
+	case '"':
+		if (!match_node_text(p, &s))
+			return errno = EINVAL, 0;
+#ifdef JSON_LAZY_UNESCAPE
+		if (p->lazy)
+			obj->escaped |= lazy_string(p, s, JSN_ESCAPED_STRING);
+#endif
+		obj->data.string = s;
+		return obj->type = JS_STRING;
+	case 'n':
+		if (s[1] != 'u' || s[2] != 'l' || s[3] != 'l' || is_id_char(s[4]))
+			return errno = EINVAL, 0;
+		p->ptr = s + 4;
+		return obj->type = JS_NULL;
+	case 't':
+		if (s[1] != 'r' || s[2] != 'u' || s[3] != 'e' || is_id_char(s[4]))
+			return errno = EINVAL, 0;
+		p->ptr = s + 4;
+		obj->data.number = 1;
+		return obj->type = JS_BOOLEAN;
+	case 'f':
+		if (s[1] != 'a' || s[2] != 'l' || s[3] != 's'  || s[4] != 'e' || is_id_char(s[5]))
+			return errno = EINVAL, 0;
+		p->ptr = s + 5;
+		obj->data.number = 0;
+		return obj->type = JS_BOOLEAN;
+	default:
+		return match_number(&p->ptr, obj) ?: ( errno = EINVAL, 0);
+	}
+}
+
+
+#ifdef JSON_SHORT_NEXT
+#define NEXT_MAX SHRT_MAX
+#else
+#define NEXT_MAX INT_MAX
+#endif
+
+
+/* ------------------------------------------------------------------------ */
+/* open array or object of explicit stack of match_json() */
+typedef
+struct jsn_level {
+	int obj_ofs;   /* offset of array/object node */
+	int prev_ofs;  /* offset of the last element node */
+	int start;     /* free_node_index after the array/object node, offsets are 0 by json_count_nodes() */
+	int index;     /* number of matched elements */
+	int is_object;
+} jsn_level_t;
+
+
+/* ------------------------------------------------------------------------ */
+static int close_level(jsn_parser_t *p, jsn_level_t *l)
+{
+	int table = 0;
+#if defined(JSON_HASH_INDEX) || defined(JSON_ARRAY_INDEX)
+	int table_nodes = 0;
+#ifdef JSON_HASH_INDEX
+	if (l->is_object && l->index >= JSON_HASH_INDEX_MIN_KEYS)
+		table_nodes = json_hash_nodes(l->index);
+#endif
+#ifdef JSON_ARRAY_INDEX
+	/* flat arrays (one node per element) are indexed without table */
+	if (!l->is_object && l->index >= JSON_ARRAY_INDEX_MIN_LENGTH && (int)p->free_node_index - l->start != l->index)
+		table_nodes = json_cells_nodes(l->index);
+#endif
+	/* the table is not built if its offset from the array/object node does not fit jsn_next_t */
+	if ((int)p->free_node_index - (l->start - 1) > NEXT_MAX)
+		table_nodes = 0;
+	for (int i = 0; i < table_nodes; ++i) {
+		jsn_t *node = p->alloc(p);
+		if (!node)
+			return 0;
+		if (!i)
+			table = (int)(node - p->pool) - l->obj_ofs;
+	}
+#endif
+
+	jsn_t *obj = p->pool + l->obj_ofs;
+	obj->data.length = l->index;
+#if defined(JSON_HASH_INDEX) || defined(JSON_ARRAY_INDEX)
+	obj->data.index = table;
+#else
+	(void)table;
+#endif
+	obj->type = l->is_object ? JS_OBJECT : JS_ARRAY;
+	STATS(p, ++p->stats->nodes[(int)obj->type]);
+	return obj->type;
+}
+
+
+/* ------------------------------------------------------------------------ */
+/* iterative: nesting levels are kept in explicit stack limited by JSON_MAX_DEPTH */
+static int match_json(jsn_parser_t *p, jsn_t *node)
+{
+	jsn_level_t stack[JSON_MAX_DEPTH], *l = stack;
+	int depth = 0; /* number of open levels, l is the innermost one */
+
+	for (;;) {
+		int open_char = skip_space(p);
+		if (open_char == '[' || open_char == '{') {
+			if (depth == JSON_MAX_DEPTH)
+				return errno = ELOOP, 0;
+			p->ptr += 1;
+			l = stack + depth++;
+			STATS(p, if (depth > p->stats->max_depth) p->stats->max_depth = depth);
+			l->obj_ofs = l->prev_ofs = (int)(node - p->pool);
+			l->start = (int)p->free_node_index;
+			l->index = 0;
+			l->is_object = open_char == '{';
+			if (!match_token(p, l->is_object ? '}' : ']'))
+				goto _element;
+			if (!close_level(p, l))
+				return 0;
+			l = stack + (--depth ? depth - 1 : 0);
+		} else {
+			if (!match_scalar(p, node, open_char))
+				return 0;
+			STATS(p, ++p->stats->nodes[(int)node->type]);
+		}
+
+		/* the value is matched, continue or close its arrays/objects */
+		for (;;) {
+			if (!depth)
+				return 1;
+			++l->index;
+			if (match_token(p, ','))
+				break;
+			if (!match_token(p, l->is_object ? '}' : ']'))
+				return errno = EINVAL, 0;
+			if (!close_level(p, l))
+				return 0;
+			l = stack + (--depth ? depth - 1 : 0);
+		}
+
+_element:
+		node = p->alloc(p);
+		if (!node)
+			return 0;
+
+		int node_ofs = (int)(node - p->pool);
+		if (l->obj_ofs != l->prev_ofs)
+			p->pool[l->prev_ofs].next = node_ofs - l->obj_ofs;
+		l->prev_ofs = node_ofs;
+
+		skip_space(p);
+		if (l->is_object) {
+			char *id;
+			if (!match_node_text(p, &id))
+				return errno = EINVAL, 0;
+#ifdef JSON_LAZY_UNESCAPE
+			if (p->lazy)
+				node->escaped |= lazy_string(p, id, JSN_ESCAPED_ID);
+#endif
+			node->id.string = id;
+			node->id_type = JS_STRING;
+			if (!match_token(p, ':'))
+				return errno = EINVAL, 0;
+		} else {
+			node->id.number = l->index;
+			node->id_type = JS_NUMBER;
+		}
+	}
+}
+
+
+/* ------------------------------------------------------------------------ */
+static int match_root(jsn_parser_t *p)
+{
+	char *end = NULL; /* end of length bounded text */
+#ifdef JSON_PARSE_N_FN
+	end = p->end;
+#endif
+#ifdef JSON_TWO_STAGE
+	if (!end)
+		index_init(&p->index, p->text);
+#endif
+	if (!match_json(p, p->alloc(p)))
+		return p->text - p->ptr; // return negative offset to error
+
+	int concatenated = 0;
+#ifdef JSON_PARSE_NEXT_FN
+	concatenated = p->concatenated;
+#endif
+	if ((skip_space(p) && !concatenated) || (end && p->ptr != end))
+		return errno = EMSGSIZE, p->text - p->ptr;
+
+	return p->free_node_index - p->root_index;
+}
+
+
+/* ------------------------------------------------------------------------ */
+static int basic_parse(jsn_parser_t *p)
+{
+	int unescape = 1;
+#ifdef JSON_PARSE_N_FN
+	unescape = !p->end; /* strings are unescaped to separate buffer already */
+#endif
+#ifdef JSON_LAZY_UNESCAPE
+	p->lazy = unescape;
+	unescape = 0;
+#endif
+#ifdef JSON_STATS
+	p->stats = stats_collector;
+#endif
+
+	STATS(p, stats_lap(p, NULL));
+	int len = match_root(p);
+	STATS(p, stats_lap(p, &p->stats->match_ns));
+	if (len <= 0) {
+#ifdef JSON_LAZY_UNESCAPE
+		if (p->lazy)
+			lazy_restore(p); /* the text is not corrupted on errors */
+#endif
+		STATS(p, stats_done(p, len));
+		return len;
+	}
+
+	/* backward, so children are ready before lookup table of their object is built */
+	for (int i = p->free_node_index - 1; i >= (int)p->root_index; --i) {
+		jsn_t *node = p->pool + i;
+		if (unescape && node->type == JS_STRING)
+			string_unescape(node->data.string, node->data.string);
+		if (unescape && node->id_type == JS_STRING)
+			string_unescape(node->id.string, node->id.string);
+#ifdef JSON_HASH_INDEX
+		if (node->type == JS_OBJECT && node->data.index)
+			json_hash_build(node);
+#endif
+#ifdef JSON_ARRAY_INDEX
+		if (node->type == JS_ARRAY && node->data.index)
+			json_cells_build(node);
+#endif
+	}
+	STATS(p, stats_lap(p, &p->stats->post_ns), stats_done(p, len));
+
+	return p->free_node_index - p->root_index; // return number of parsed js nodes (>0)
+}
+
+
+/* ------------------------------------------------------------------------ */
+static jsn_t *jsn_alloc(jsn_parser_t *p)
+{
+	if (p->free_node_index >= p->pool_size)
+		return errno = ENOMEM, NULL;
+	jsn_t *j = p->pool + p->free_node_index++;
+	j->next = 0;
+	j->id_type = 0;
+	j->type = 0;
+#ifdef JSON_LAZY_UNESCAPE
+	j->escaped = 0;
+#endif
+	return j;
+}
+
+
+/* ------------------------------------------------------------------------ */
+int json_parse(jsn_t *pool, size_t size, char *text)
+{
+	jsn_parser_t p = {
+		.text = text,
+		.ptr = text,
+		.pool = pool,
+		.free_node_index = 0,
+		.pool_size = size,
+		.alloc = jsn_alloc
+	};
+
+	return basic_parse(&p);
+}
+
+#ifdef JSON_PARSE_NEXT_FN
+
+/* ------------------------------------------------------------------------ */
+int json_parse_next(jsn_t *pool, size_t size, char *text, char **next)
+{
+	if (!after_space(&text))
+		return *next = text, errno = ENODATA, 0;
+
+	jsn_parser_t p = {
+		.text = text,
+		.ptr = text,
+		.pool = pool,
+		.free_node_index = 0,
+		.pool_size = size,
+		.alloc = jsn_alloc,
+		.concatenated = 1
+	};
+
+	int len = basic_parse(&p);
+	*next = p.ptr; /* the next document or error */
+	return len;
+}
+
+#endif
+
+#ifdef JSON_PARSE_N_FN
+
+/* ------------------------------------------------------------------------ */
+int json_parse_n(jsn_t *pool, size_t size, char const *text, size_t len, char *strings, size_t strings_size)
+{
+	jsn_parser_t p = {
+		.text = (char *)text,
+		.ptr = (char *)text,
+		.pool = pool,
+		.free_node_index = 0,
+		.pool_size = size,
+		.alloc = jsn_alloc,
+		.end = (char *)text + len,
+		.strings = strings,
+		.strings_end = strings + strings_size
+	};
+
+	int ret = basic_parse(&p);
+	if (ret <= 0 && !p.strings_end)
+		errno = ENOBUFS;
+	return ret;
+}
+
+#endif
+
+
+/* ------------------------------------------------------------------------ */
+static jsn_t *jsn_count(jsn_parser_t *p)
+{
+	++p->free_node_index;
+	return p->pool; /* all nodes are written to the same scratch node */
+}
+
+
+/* ------------------------------------------------------------------------ */
+int json_count_nodes(char const *text)
+{
+	jsn_t scratch;
+	jsn_parser_t p = {
+		.text = (char *)text,
+		.ptr = (char *)text,
+		.pool = &scratch,
+		.free_node_index = 0,
+		.pool_size = 1,
+		.alloc = jsn_count
+	};
+
+	return match_root(&p);
+}
+
+#ifdef JSON_SAX_FN
+
+/* calls optional handler of event, nonzero result of the handler cancels parsing */
+#define SAX_EVENT(p, event, ...) \
+	(!(p)->handlers->event || !(p)->handlers->event((p)->ctx, ##__VA_ARGS__) || (errno = ECANCELED, 0))
+
+/* ------------------------------------------------------------------------ */
+/* iterative like match_json(), the only node is reused for every value */
+static int match_sax(jsn_parser_t *p, jsn_t *node)
+{
+	jsn_level_t stack[JSON_MAX_DEPTH], *l = stack;
+	int depth = 0;
+
+	for (;;) {
+		int open_char = skip_space(p);
+		if (open_char == '[' || open_char == '{') {
+			if (depth == JSON_MAX_DEPTH)
+				return errno = ELOOP, 0;
+			p->ptr += 1;
+			l = stack + depth++;
+			l->index = 0;
+			l->is_object = open_char == '{';
+			if (!(l->is_object ? SAX_EVENT(p, start_object) : SAX_EVENT(p, start_array)))
+				return 0;
+			++p->free_node_index;
+			if (!match_token(p, l->is_object ? '}' : ']'))
+				goto _element;
+			if (!(l->is_object ? SAX_EVENT(p, end_object) : SAX_EVENT(p, end_array)))
+				return 0;
+			l = stack + (--depth ? depth - 1 : 0);
+		} else {
+			if (!match_scalar(p, node, open_char))
+				return 0;
+			if (node->type == JS_STRING)
+				string_unescape(node->data.string, node->data.string);
+			++p->free_node_index;
+			if (!SAX_EVENT(p, value, node))
+				return 0;
+		}
+
+		/* the value is matched, continue or close its arrays/objects */
+		for (;;) {
+			if (!depth)
+				return 1;
+			++l->index;
+			if (match_token(p, ','))
+				break;
+			if (!match_token(p, l->is_object ? '}' : ']'))
+				return errno = EINVAL, 0;
+			if (!(l->is_object ? SAX_EVENT(p, end_object) : SAX_EVENT(p, end_array)))
+				return 0;
+			l = stack + (--depth ? depth - 1 : 0);
+		}
+
+_element:
+		skip_space(p);
+		if (l->is_object) {
+			char *id;
+			if (!match_text(p, &id) || !match_token(p, ':'))
+				return errno = EINVAL, 0;
+			string_unescape(id, id);
+			if (!SAX_EVENT(p, key, id))
+				return 0;
+			node->id.string = id;
+			node->id_type = JS_STRING;
+		} else {
+			node->id.number = l->index;
+			node->id_type = JS_NUMBER;
+		}
+	}
+}
+
+
+/* ------------------------------------------------------------------------ */
+int json_sax_parse(char *text, jsn_handlers_t const *handlers, void *ctx)
+{
+	jsn_parser_t p = {
+		.text = text,
+		.ptr = text,
+		.pool = NULL,
+		.free_node_index = 0,
+		.pool_size = 0,
+		.alloc = NULL,
+		.handlers = handlers,
+		.ctx = ctx
+	};
+
+#ifdef JSON_TWO_STAGE
+	index_init(&p.index, text);
+#endif
+	jsn_t root = { .next = 0, .id_type = 0 };
+	if (!match_sax(&p, &root))
+		return p.text - p.ptr; // return negative offset to error
+
+	if (skip_space(&p))
+		return errno = EMSGSIZE, p.text - p.ptr;
+
+	return p.free_node_index; // return number of parsed values (>0)
+}
+
+#endif /* JSON_SAX_FN */
+
+#if defined(JSON_AUTO_PARSE_FN) || defined(JSON_ARENA_FN) || defined(JSON_FEED_FN) || defined(JSON_NDJSON_FN)
+
+/* ------------------------------------------------------------------------ */
+static jsn_t *jsn_realloc(jsn_parser_t *p)
+{
+	if (p->free_node_index >= p->pool_size) {
+		jsn_t *pool = realloc(p->pool, sizeof(jsn_t) * JSON_AUTO_PARSE_POOL_INCREASE(p->pool_size));
+		if (!pool)
+			return NULL;
+		p->pool = pool;
+		p->pool_size = JSON_AUTO_PARSE_POOL_INCREASE(p->pool_size);
+		STATS(p, ++p->stats->reallocs);
+	}
+	return jsn_alloc(p);
+}
+
+#endif
+
+#ifdef JSON_AUTO_PARSE_FN
+
+/* ------------------------------------------------------------------------ */
+static int jsn_free_tail(jsn_parser_t *p)
+{
+	if (p->free_node_index < p->pool_size) {
+		jsn_t *pool = realloc(p->pool, sizeof(jsn_t) * p->free_node_index);
+		if (!pool)
+			return -1;
+		p->pool = pool;
+	}
+	return 0;
+}
+
+
+/* ------------------------------------------------------------------------ */
+jsn_t *json_auto_parse(char *text, char **end)
+{
+#ifdef JSON_AUTO_PARSE_COUNT
+	int size = json_count_nodes(text);
+	if (size <= 0) {
+		if (end)
+			*end = text - size;
+		return NULL;
+	}
+
+	jsn_parser_t p = {
+		.text = text,
+		.ptr = text,
+		.free_node_index = 0,
+		.pool_size = size,
+		.pool = malloc(size * sizeof(jsn_t)),
+		.alloc = jsn_alloc
+	};
+#else
+	jsn_parser_t p = {
+		.text = text,
+		.ptr = text,
+		.free_node_index = 0,
+		.pool_size = JSON_AUTO_PARSE_POOL_START_SIZE,
+		.pool = malloc(JSON_AUTO_PARSE_POOL_START_SIZE * sizeof(jsn_t)),
+		.alloc = jsn_realloc
+	};
+#endif
+
+	if (!p.pool)
+		return NULL;
+
+	int len = basic_parse(&p);
+	if (end)
+		*end = p.ptr;
+
+	if (len <= 0) {
+		free(p.pool);
+		return NULL;
+	} else
+		jsn_free_tail(&p);
+
+	return p.pool;
+}
+
+#endif /* JSON_AUTO_PARSE */
+
+#if defined(JSON_ARENA_FN) || defined(JSON_FEED_FN)
+
+/* ------------------------------------------------------------------------ */
+void json_arena_init(jsn_arena_t *arena)
+{
+	arena->pool = NULL;
+	arena->size = 0;
+	arena->length = 0;
+}
+
+
+/* ------------------------------------------------------------------------ */
+static jsn_t *arena_parse(jsn_arena_t *arena, char *text, char **end, int concatenated)
+{
+	if (!arena->pool) {
+		arena->pool = malloc(JSON_AUTO_PARSE_POOL_START_SIZE * sizeof(jsn_t));
+		if (!arena->pool)
+			return NULL;
+		arena->size = JSON_AUTO_PARSE_POOL_START_SIZE;
+	}
+
+	jsn_parser_t p = {
+		.text = text,
+		.ptr = text,
+		.free_node_index = 0,
+		.pool_size = arena->size,
+		.pool = arena->pool,
+		.alloc = jsn_realloc
+	};
+#ifdef JSON_PARSE_NEXT_FN
+	p.concatenated = concatenated;
+#else
+	(void)concatenated;
+#endif
+
+	int len = basic_parse(&p);
+	if (end)
+		*end = p.ptr;
+
+	arena->pool = p.pool; /* the pool is kept grown for next documents */
+	arena->size = p.pool_size;
+	arena->length = len > 0 ? len : 0;
 
-_empty:
-	obj->data.length = index;
-	return obj->type = (is_object ? JS_OBJECT : JS_ARRAY);
+	return len > 0 ? arena->pool : NULL;
 }
 
 
 /* ------------------------------------------------------------------------ */
-static int basic_parse(jsn_parser_t *p)
+jsn_t *json_arena_parse(jsn_arena_t *arena, char *text, char **end)
 {
-	if (!match_json(p, p->alloc(p)))
-		return p->text - p->ptr; // return negative offset to error
+	return arena_parse(arena, text, end, 0);
+}
 
-	if (after_space(&p->ptr))
-		return errno = EMSGSIZE, p->text - p->ptr;
+#ifdef JSON_PARSE_NEXT_FN
+
+/* ------------------------------------------------------------------------ */
+jsn_t *json_arena_parse_next(jsn_arena_t *arena, char *text, char **next)
+{
+	if (!after_space(&text)) {
+		arena->length = 0;
+		return *next = text, errno = ENODATA, NULL;
+	}
+	return arena_parse(arena, text, next, 1);
+}
+
+#endif
+
+
+/* ------------------------------------------------------------------------ */
+void json_arena_reset(jsn_arena_t *arena)
+{
+	arena->length = 0;
+}
+
+
+/* ------------------------------------------------------------------------ */
+void json_arena_destroy(jsn_arena_t *arena)
+{
+	free(arena->pool);
+	json_arena_init(arena);
+}
+
+#endif /* JSON_ARENA_FN */
+
+#ifdef JSON_FEED_FN
+
+/*
+	Resumable parser: chunks are parsed as they arrive by a state machine that
+	keeps the open arrays/objects in jsn_level_t stack of the feed and builds
+	nodes like match_json() does. Only strings and scalars are copied from
+	chunks (to the strings buffer, where a token split by chunks is joined),
+	the text itself is not buffered and no byte is scanned twice. Nodes keep
+	offsets of their strings in the buffer, which may be moved by realloc,
+	until the document is complete.
+*/
+
+#define FEED_STRINGS_START_SIZE 256
+
+enum { /* what the next char of the stream is expected to be */
+	FEED_START,     /* spaces before the document */
+	FEED_VALUE,     /* a value */
+	FEED_FIRST,     /* a value or ']' after '[' */
+	FEED_FIRST_KEY, /* a key or '}' after '{' */
+	FEED_KEY,       /* a key after ',' in object */
+	FEED_COLON,     /* ':' after a key */
+	FEED_NEXT,      /* ',' or closing bracket after a value, the document end at root */
+	FEED_STRING,    /* a char of string */
+	FEED_STRING_ESCAPE,
+	FEED_ID,        /* a char of key */
+	FEED_ID_ESCAPE,
+	FEED_SCALAR,    /* a char of number or literal */
+	FEED_DONE       /* the document is complete or broken */
+};
+
+/* ------------------------------------------------------------------------ */
+void json_feed_init(jsn_feed_t *feed)
+{
+	json_arena_init(&feed->arena);
+	feed->strings = NULL;
+	feed->length = 0;
+	feed->size = 0;
+	feed->token = 0;
+	feed->node = 0;
+	feed->levels = NULL;
+	feed->depth = 0;
+	feed->state = FEED_START;
+}
+
+
+/* ------------------------------------------------------------------------ */
+static int feed_append(jsn_feed_t *f, char const *s, size_t n)
+{
+	if (f->length + n + 1 > f->size) {
+		size_t size = f->size ? f->size : FEED_STRINGS_START_SIZE;
+		while (size < f->length + n + 1)
+			size *= 2;
+		char *strings = realloc(f->strings, size);
+		if (!strings)
+			return 0;
+		f->strings = strings;
+		f->size = size;
+	}
+	memcpy(f->strings + f->length, s, n);
+	f->length += n;
+	return 1;
+}
+
+
+/* ------------------------------------------------------------------------ */
+/* unescapes the received string in place, returns its offset */
+static char *feed_string(jsn_parser_t *p, jsn_feed_t *f)
+{
+	char *s = f->strings + f->token;
+	f->strings[f->length] = 0;
+	STATS(p, p->stats->string_bytes += f->length - f->token, ++p->stats->strings,
+		p->stats->escaped += !!memchr(s, '\\', f->length - f->token));
+	string_unescape(s, s);
+	f->length = f->token + strlen(s) + 1;
+	return (char *)(uintptr_t)f->token;
+}
+
+
+/* ------------------------------------------------------------------------ */
+/* matches the received number or literal of the node */
+static int feed_scalar(jsn_parser_t *p, jsn_feed_t *f)
+{
+	char *s = f->strings + f->token;
+	f->strings[f->length] = 0;
+	f->length = f->token;
+
+	jsn_parser_t q = { .text = s, .ptr = s };
+	jsn_t *node = p->pool + f->node;
+	if (!match_scalar(&q, node, *s) || *q.ptr)
+		return errno = EINVAL, 0;
+	STATS(p, ++p->stats->nodes[(int)node->type]);
+	return 1;
+}
+
+
+/* ------------------------------------------------------------------------ */
+/* allocates node of next element of the innermost level like match_json() */
+static int feed_element(jsn_parser_t *p, jsn_feed_t *f)
+{
+	jsn_level_t *l = f->levels + f->depth - 1;
+	jsn_t *node = p->alloc(p);
+	if (!node)
+		return 0;
+
+	int node_ofs = (int)(node - p->pool);
+	if (l->obj_ofs != l->prev_ofs)
+		p->pool[l->prev_ofs].next = node_ofs - l->obj_ofs;
+	l->prev_ofs = node_ofs;
+
+	if (l->is_object)
+		node->id_type = JS_STRING;
+	else {
+		node->id.number = l->index;
+		node->id_type = JS_NUMBER;
+	}
+	f->node = node_ofs;
+	return 1;
+}
 
-	for (int i = 0; i < p->free_node_index; ++i) {
+
+/* ------------------------------------------------------------------------ */
+/* the document is complete: strings offsets to pointers, lookup tables like basic_parse() */
+static void feed_done(jsn_parser_t *p, jsn_feed_t *f)
+{
+	for (int i = p->free_node_index - 1; i >= 0; --i) {
 		jsn_t *node = p->pool + i;
 		if (node->type == JS_STRING)
-			string_unescape(node->data.string, node->data.string);
+			node->data.string = f->strings + (uintptr_t)node->data.string;
 		if (node->id_type == JS_STRING)
-			string_unescape(node->id.string, node->id.string);
+			node->id.string = f->strings + (uintptr_t)node->id.string;
+#ifdef JSON_HASH_INDEX
+		if (node->type == JS_OBJECT && node->data.index)
+			json_hash_build(node);
+#endif
+#ifdef JSON_ARRAY_INDEX
+		if (node->type == JS_ARRAY && node->data.index)
+			json_cells_build(node);
+#endif
 	}
-
-	return p->free_node_index; // return number of parsed js nodes (>0)
+	f->state = FEED_DONE;
 }
 
 
 /* ------------------------------------------------------------------------ */
-static jsn_t *jsn_alloc(jsn_parser_t *p)
+/* parses the chunk up to the document end, returns 1 - complete, 0 - error, -1 - more data is needed */
+static int feed_chunk(jsn_parser_t *p, jsn_feed_t *f, char const *s, size_t len, size_t *taken)
 {
-	if (p->free_node_index >= p->pool_size)
-		return errno = ENOMEM, NULL;
-	jsn_t *j = p->pool + p->free_node_index++;
-	j->next = 0;
-	j->type = 0;
-	return j;
+	size_t i = 0;
+	for (;; ++i) {
+		if (f->state == FEED_NEXT && !f->depth)
+			return feed_done(p, f), *taken = i, 1;
+		if (i == len)
+			return *taken = i, -1;
+
+		int c = s[i];
+		jsn_level_t *l = f->depth ? f->levels + f->depth - 1 : NULL;
+		switch (f->state) {
+		case FEED_STRING:
+		case FEED_ID: { /* copy the run up to quote or backslash at once */
+				size_t n = i;
+				while (n < len && s[n] != '"' && s[n] != '\\')
+					++n;
+				if (!feed_append(f, s + i, n - i))
+					return *taken = n, 0;
+				if ((i = n) == len)
+					return *taken = i, -1;
+				c = s[i];
+				if (c == '\\') {
+					f->state = f->state == FEED_ID ? FEED_ID_ESCAPE : FEED_STRING_ESCAPE;
+					if (!feed_append(f, s + i, 1))
+						return *taken = i + 1, 0;
+				} else
+					if (f->state == FEED_ID) {
+						p->pool[f->node].id.string = feed_string(p, f);
+						f->state = FEED_COLON;
+					} else {
+						p->pool[f->node].data.string = feed_string(p, f);
+						p->pool[f->node].type = JS_STRING;
+						STATS(p, ++p->stats->nodes[JS_STRING]);
+						f->state = FEED_NEXT;
+					}
+			}
+			continue;
+
+		case FEED_STRING_ESCAPE:
+		case FEED_ID_ESCAPE:
+			if (!feed_append(f, s + i, 1))
+				return *taken = i + 1, 0;
+			f->state = f->state == FEED_ID_ESCAPE ? FEED_ID : FEED_STRING;
+			continue;
+
+		case FEED_SCALAR:
+			if (is_id_char(c) || c == '.' || c == '-' || c == '+') {
+				size_t n = i;
+				while (n < len && (is_id_char(s[n]) || s[n] == '.' || s[n] == '-' || s[n] == '+'))
+					++n;
+				if (!feed_append(f, s + i, n - i))
+					return *taken = n, 0;
+				i = n - 1;
+				continue;
+			}
+			if (!feed_scalar(p, f))
+				return *taken = i, 0;
+			f->state = FEED_NEXT;
+			--i; /* the char is not a part of the scalar */
+			continue;
+
+		default:
+			if (is_space(c))
+				continue;
+		}
+
+		switch (f->state) {
+		case FEED_START: {
+				jsn_t *root = p->alloc(p);
+				if (!root)
+					return *taken = i, 0;
+				f->node = (int)(root - p->pool);
+				f->state = FEED_VALUE;
+			}
+			/* fall through */
+
+		case FEED_VALUE:
+			if (c == '[' || c == '{') {
+				if (f->depth == JSON_MAX_DEPTH)
+					return *taken = i + 1, errno = ELOOP, 0;
+				l = f->levels + f->depth++;
+				STATS(p, if (f->depth > p->stats->max_depth) p->stats->max_depth = f->depth);
+				l->obj_ofs = l->prev_ofs = f->node;
+				l->start = (int)p->free_node_index;
+				l->index = 0;
+				l->is_object = c == '{';
+				f->state = l->is_object ? FEED_FIRST_KEY : FEED_FIRST;
+				continue;
+			}
+			f->token = f->length;
+			if (!feed_append(f, "", 0)) /* room for the terminating zero */
+				return *taken = i, 0;
+			if (c == '"') {
+				f->state = FEED_STRING;
+				continue;
+			}
+			if (!is_id_char(c) && c != '-' && c != '+' && c != '.')
+				return *taken = i + 1, errno = EINVAL, 0;
+			f->state = FEED_SCALAR;
+			--i; /* the scalar is copied from its first char */
+			continue;
+
+		case FEED_FIRST:
+		case FEED_FIRST_KEY:
+			if (c == (l->is_object ? '}' : ']'))
+				break;
+			if (l->is_object) {
+				f->state = FEED_KEY;
+				--i;
+				continue;
+			}
+			if (!feed_element(p, f))
+				return *taken = i, 0;
+			f->state = FEED_VALUE;
+			--i;
+			continue;
+
+		case FEED_KEY:
+			if (c != '"')
+				return *taken = i + 1, errno = EINVAL, 0;
+			if (!feed_element(p, f))
+				return *taken = i, 0;
+			f->token = f->length;
+			if (!feed_append(f, "", 0))
+				return *taken = i, 0;
+			f->state = FEED_ID;
+			continue;
+
+		case FEED_COLON:
+			if (c != ':')
+				return *taken = i + 1, errno = EINVAL, 0;
+			f->state = FEED_VALUE;
+			continue;
+
+		case FEED_NEXT:
+			++l->index;
+			if (c == ',') {
+				if (l->is_object)
+					f->state = FEED_KEY;
+				else {
+					if (!feed_element(p, f))
+						return *taken = i, 0;
+					f->state = FEED_VALUE;
+				}
+				continue;
+			}
+			if (c == (l->is_object ? '}' : ']'))
+				break;
+			return *taken = i + 1, errno = EINVAL, 0;
+
+		default:
+			return *taken = i, errno = EINVAL, 0;
+		}
+
+		/* the closing bracket of the innermost level */
+		if (!close_level(p, l))
+			return *taken = i + 1, 0;
+		f->node = l->obj_ofs;
+		--f->depth;
+		f->state = FEED_NEXT;
+	}
 }
 
 
 /* ------------------------------------------------------------------------ */
-int json_parse(jsn_t *pool, size_t size, char *text)
+jsn_t *json_parser_feed(jsn_feed_t *feed, char const **chunk, size_t *len)
 {
+	if (feed->state == FEED_DONE) { /* forget the previous document */
+		feed->arena.length = 0;
+		feed->depth = 0;
+		feed->state = FEED_START;
+	}
+
+	if (!feed->strings && !feed_append(feed, "", 0))
+		return NULL;
+	if (!feed->levels) {
+		feed->levels = malloc(JSON_MAX_DEPTH * sizeof(jsn_level_t));
+		if (!feed->levels)
+			return NULL;
+	}
+	if (!feed->arena.pool) {
+		feed->arena.pool = malloc(JSON_AUTO_PARSE_POOL_START_SIZE * sizeof(jsn_t));
+		if (!feed->arena.pool)
+			return NULL;
+		feed->arena.size = JSON_AUTO_PARSE_POOL_START_SIZE;
+	}
+	if (feed->state == FEED_START)
+		feed->length = 0;
+
 	jsn_parser_t p = {
-		.text = text,
-		.ptr = text,
-		.pool = pool,
-		.free_node_index = 0,
-		.pool_size = size,
-		.alloc = jsn_alloc
+		.pool = feed->arena.pool,
+		.free_node_index = feed->arena.length,
+		.pool_size = feed->arena.size,
+		.alloc = jsn_realloc
 	};
-
-	return basic_parse(&p);
+#ifdef JSON_STATS
+	p.stats = stats_collector;
+#endif
+	STATS(&p, stats_lap(&p, NULL));
+
+	int result;
+	if (chunk) {
+		size_t taken = 0;
+		result = feed_chunk(&p, feed, *chunk, *len, &taken);
+		*chunk += taken;
+		*len -= taken;
+	} else /* end of stream: a number or literal at root is complete */
+		if (feed->state == FEED_START)
+			result = (errno = ENODATA, -2);
+		else
+			if (feed->state == FEED_SCALAR && !feed->depth && feed_scalar(&p, feed))
+				result = 1, feed_done(&p, feed);
+			else
+				result = (errno = EINVAL, 0);
+
+	feed->arena.pool = p.pool; /* the pool is kept grown for next documents */
+	feed->arena.size = p.pool_size;
+	feed->arena.length = p.free_node_index;
+
+	STATS(&p, stats_lap(&p, &p.stats->match_ns));
+	if (result == -1)
+		return errno = EAGAIN, NULL;
+	if (result == -2)
+		return NULL;
+	STATS(&p, stats_done(&p, result > 0 ? (int)p.free_node_index : -1));
+	if (!result) {
+		feed->arena.length = 0;
+		feed->state = FEED_DONE; /* the broken document is skipped */
+		return NULL;
+	}
+	return feed->arena.pool;
 }
 
-#ifdef JSON_AUTO_PARSE_FN
 
 /* ------------------------------------------------------------------------ */
-static jsn_t *jsn_realloc(jsn_parser_t *p)
+void json_feed_destroy(jsn_feed_t *feed)
 {
-	if (p->free_node_index >= p->pool_size) {
-		jsn_t *pool = realloc(p->pool, sizeof(jsn_t) * JSON_AUTO_PARSE_POOL_INCREASE(p->pool_size));
-		if (!pool)
-			return NULL;
-		p->pool = pool;
-		p->pool_size = JSON_AUTO_PARSE_POOL_INCREASE(p->pool_size);
-	}
-	return jsn_alloc(p);
+	json_arena_destroy(&feed->arena);
+	free(feed->strings);
+	free(feed->levels);
+	json_feed_init(feed);
 }
 
+#endif /* JSON_FEED_FN */
+
+#ifdef JSON_NDJSON_FN
+
+/* records of a thread are parsed one by one to its growing pool */
+typedef
+struct jsn_ndjson_job {
+	char **texts;       /* zero terminated records of all jobs */
+	jsn_t **roots;      /* roots of all jobs */
+	size_t first, last; /* records [first, last) of the job */
+	jsn_t *pool;        /* nodes of the job records */
+	size_t failures;    /* number of failed records */
+	pthread_t thread;
+	int started;        /* the thread is created */
+#ifdef JSON_STATS
+	jsn_stats_t *stats; /* counters of the job records, NULL - not collected */
+#endif
+} jsn_ndjson_job_t;
+
+#ifdef JSON_STATS
 
 /* ------------------------------------------------------------------------ */
-static int jsn_free_tail(jsn_parser_t *p)
+/* adds counters of a job to the stats of json_ndjson_parse() caller */
+static void stats_merge(jsn_stats_t *s, jsn_stats_t const *job)
 {
-	if (p->free_node_index < p->pool_size) {
-		jsn_t *pool = realloc(p->pool, sizeof(jsn_t) * p->free_node_index);
-		if (!pool)
-			return -1;
-		p->pool = pool;
-	}
-	return 0;
+	s->parses += job->parses;
+	s->failures += job->failures;
+	for (int i = 0; i <= JS_OBJECT; ++i)
+		s->nodes[i] += job->nodes[i];
+	s->strings += job->strings;
+	s->escaped += job->escaped;
+	s->string_bytes += job->string_bytes;
+	s->reallocs += job->reallocs;
+	if (job->max_depth > s->max_depth)
+		s->max_depth = job->max_depth;
+	if (job->max_nodes > s->max_nodes)
+		s->max_nodes = job->max_nodes;
+	s->match_ns += job->match_ns;
+	s->post_ns += job->post_ns;
 }
 
+#endif
+
 
 /* ------------------------------------------------------------------------ */
-jsn_t *json_auto_parse(char *text, char **end)
+static void *ndjson_job(void *arg)
 {
+	jsn_ndjson_job_t *job = arg;
+	size_t *offsets = malloc((job->last - job->first) * sizeof(size_t) + 1); /* roots while the pool grows */
 	jsn_parser_t p = {
-		.text = text,
-		.ptr = text,
 		.free_node_index = 0,
 		.pool_size = JSON_AUTO_PARSE_POOL_START_SIZE,
 		.pool = malloc(JSON_AUTO_PARSE_POOL_START_SIZE * sizeof(jsn_t)),
 		.alloc = jsn_realloc
 	};
+#ifdef JSON_STATS
+	jsn_stats_t *collector = json_stats(job->stats); /* the records are counted by the job */
+#endif
 
-	if (!p.pool)
-		return NULL;
+	for (size_t i = job->first; i < job->last; ++i) {
+		p.text = p.ptr = job->texts[i];
+		p.root_index = p.free_node_index;
+		if (!offsets || !p.pool || basic_parse(&p) <= 0) {
+			p.free_node_index = p.root_index; /* nodes of failed record are reused */
+			if (offsets)
+				offsets[i - job->first] = (size_t)-1;
+			++job->failures;
+		} else
+			offsets[i - job->first] = p.root_index;
+	}
 
-	int len = basic_parse(&p);
-	if (end)
-		*end = p.ptr;
+	for (size_t i = job->first; i < job->last; ++i)
+		job->roots[i] = offsets && offsets[i - job->first] != (size_t)-1 ? p.pool + offsets[i - job->first] : NULL;
+	free(offsets);
+	job->pool = p.pool;
+#ifdef JSON_STATS
+	json_stats(collector);
+#endif
+	return NULL;
+}
 
-	if (len <= 0) {
-		free(p.pool);
-		return NULL;
-	} else
-		jsn_free_tail(&p);
 
-	return p.pool;
+/* ------------------------------------------------------------------------ */
+/* splits text to zero terminated not blank lines */
+static size_t ndjson_records(char *text, char ***texts)
+{
+	size_t length = 0, size = 0;
+	for (char *s = text; *s;) {
+		char *e = strchrnul(s, '\n'), *c = s;
+		while (c < e && is_space(*c))
+			++c;
+		if (c < e) {
+			if (length == size) {
+				char **t = realloc(*texts, (size = size * 2 + 1024) * sizeof(char *));
+				if (!t)
+					return (size_t)-1;
+				*texts = t;
+			}
+			(*texts)[length++] = s;
+		}
+		if (!*e)
+			break;
+		*e = 0;
+		s = e + 1;
+	}
+	return length;
 }
 
-#endif /* JSON_AUTO_PARSE */
 
-#ifdef JSON_GET_FN
+/* ------------------------------------------------------------------------ */
+int json_ndjson_parse(jsn_ndjson_t *docs, char *text, int threads)
+{
+	*docs = (jsn_ndjson_t){ .roots = NULL };
+
+	char **texts = NULL;
+	size_t length = ndjson_records(text, &texts);
+	if (length == (size_t)-1) {
+		free(texts);
+		return errno = ENOMEM, -1;
+	}
+	if (threads <= 0)
+		threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	if ((size_t)threads > length)
+		threads = length ? (int)length : 1;
+
+	docs->roots = malloc(length * sizeof(jsn_t *) + 1);
+	docs->pools = calloc(threads, sizeof(jsn_t *));
+	jsn_ndjson_job_t *jobs = calloc(threads, sizeof(jsn_ndjson_job_t));
+	if (!docs->roots || !docs->pools || !jobs) {
+		free(jobs);
+		free(texts);
+		json_ndjson_free(docs);
+		return errno = ENOMEM, -1;
+	}
+	docs->length = length;
+	docs->threads = threads;
+
+#ifdef JSON_STATS
+	/* workers count to their own stats, the caller's ones get the sum */
+	jsn_stats_t *collector = stats_collector, *stats = collector ? calloc(threads, sizeof(jsn_stats_t)) : NULL;
+#endif
+
+	/* contiguous ranges of records of about the same text size */
+	size_t size = length ? (size_t)(texts[length - 1] - text) + 1 : 1, i = 0;
+	for (int k = 0; k < threads; ++k) {
+		jobs[k].texts = texts;
+		jobs[k].roots = docs->roots;
+		jobs[k].first = i;
+		while (i < length && (k == threads - 1 || (size_t)(texts[i] - text) < size / threads * (k + 1)))
+			++i;
+		jobs[k].last = i;
+#ifdef JSON_STATS
+		jobs[k].stats = stats ? stats + k : NULL;
+#endif
+	}
+
+	/* the first range is parsed by the calling thread, the other ones are too if threads are not created */
+	for (int k = 1; k < threads; ++k)
+		jobs[k].started = !pthread_create(&jobs[k].thread, NULL, ndjson_job, jobs + k);
+	ndjson_job(jobs);
+	for (int k = 1; k < threads; ++k)
+		if (jobs[k].started)
+			pthread_join(jobs[k].thread, NULL);
+		else
+			ndjson_job(jobs + k);
+
+	for (int k = 0; k < threads; ++k) {
+		docs->pools[k] = jobs[k].pool;
+		docs->failures += jobs[k].failures;
+	}
+	free(jobs);
+	free(texts);
+
+	int result = (int)(docs->length - docs->failures);
+#ifdef JSON_STATS
+	if (stats) {
+		for (int k = 0; k < threads; ++k)
+			stats_merge(collector, stats + k);
+		if (collector->hook)
+			collector->hook(collector, result);
+		free(stats);
+	}
+#endif
+	return result;
+}
+
+
+/* ------------------------------------------------------------------------ */
+void json_ndjson_free(jsn_ndjson_t *docs)
+{
+	for (int k = 0; docs->pools && k < docs->threads; ++k)
+		free(docs->pools[k]);
+	free(docs->pools);
+	free(docs->roots);
+	*docs = (jsn_ndjson_t){ .roots = NULL };
+}
+
+#endif /* JSON_NDJSON_FN */
+
+#if defined(JSON_GET_FN) || defined(JSON_PATH_FN)
 
 static int match_id(char **p, char *id)
 {
@@ -478,6 +2298,10 @@ static int match_inum(char **p, int *num)
 	return 1;
 }
 
+#endif
+
+#ifdef JSON_GET_FN
+
 /* ------------------------------------------------------------------------ */
 jsn_t *json_get(jsn_t *obj, char const *path)
 {
@@ -535,3 +2359,99 @@ path     ( '.' ID | INDEX ) )*
 }
 
 #endif /* JSON_GET_FN */
+
+#ifdef JSON_PATH_FN
+
+struct jsn_path {
+	int length;                /* number of steps */
+	struct jsn_step {
+		char const *key;       /* unescaped key of object item or NULL for array cell */
+		int index;             /* index of array cell */
+#ifdef JSON_HASH_INDEX
+		unsigned int hash;     /* json_hash() of the key */
+#endif
+	} steps[];
+};
+
+/* ------------------------------------------------------------------------ */
+jsn_path_t *json_path_compile(char const *path)
+{
+	/* every step takes at least 2 chars of path and its key is not longer than the step */
+	size_t len = strlen(path);
+	int max_steps = len / 2 + 1;
+	jsn_path_t *c = (jsn_path_t *)malloc(sizeof *c + max_steps * sizeof c->steps[0] + len + 1);
+	if (!c)
+		return errno = ENOMEM, NULL;
+
+	char *keys = (char *)(c->steps + max_steps);
+	char *p = (char *)path;
+
+	c->length = 0;
+	after_space(&p);
+	while (*p) {
+		struct jsn_step *step = c->steps + c->length++;
+		step->key = NULL;
+		switch (*p) {
+		case '.':
+			++p;
+			if (!match_id(&p, keys))
+				goto _fail;
+			break;
+
+		case '[': {
+				char *s;
+				++p;
+				if (match_inum(&p, &step->index)) {
+					if (!match_char(&p, ']'))
+						goto _fail;
+					after_space(&p);
+					continue;
+				}
+				if (!match_string(&p, &s) || !match_char(&p, ']'))
+					goto _fail;
+				string_unescape(keys, s);
+			} break;
+
+		default:
+			goto _fail;
+		}
+		step->key = keys;
+#ifdef JSON_HASH_INDEX
+		step->hash = json_hash(keys);
+#endif
+		keys += strlen(keys) + 1;
+		after_space(&p);
+	}
+	return c;
+
+_fail:
+	free(c);
+	return errno = EINVAL, NULL;
+}
+
+
+/* ------------------------------------------------------------------------ */
+jsn_t *json_path_eval(jsn_path_t const *path, jsn_t *obj)
+{
+	for (int i = 0; obj && i < path->length; ++i) {
+		struct jsn_step const *step = path->steps + i;
+		if (!step->key)
+			obj = json_cell(obj, step->index);
+		else
+#ifdef JSON_HASH_INDEX
+			obj = json_item_hash(obj, step->key, step->hash);
+#else
+			obj = json_item(obj, step->key);
+#endif
+	}
+	return obj;
+}
+
+
+/* ------------------------------------------------------------------------ */
+void json_path_free(jsn_path_t *path)
+{
+	free(path);
+}
+
+#endif /* JSON_PATH_FN */
@@ -5,40 +5,59 @@
 #include "stdarg.h"
 #include "string.h"
 #include "errno.h"
+#include "unistd.h"
+#include "sys/uio.h"
 
 #include "nano/json.h"
 
 #ifdef JSON_STRINGIFY_FN
 
+/* ------------------------------------------------------------------------ */
+/* writes to [p, e) only but counts the whole length past the end */
+static inline char *put_char(char *p, char *e, char c)
+{
+	if (p < e)
+		*p = c;
+	return p + 1;
+}
+
+
 /* ------------------------------------------------------------------------ */
 char *string_escape(char *p, char *e, char const *s)
 {
 	static char const hex[] = "0123456789abcdef";
-	while (p < e && *s) {
-		unsigned int c = (unsigned char)*s++;
-		if (c >= ' ' && c != '"' && c != '\\') {
-			*p++ = c;
-			continue;
+	for (;; ++s) {
+		/* short runs are copied by bytes, long ones are found by vectorized (JSON_SIMD) scanner */
+		char const *short_end = s + 16;
+		while (s < short_end && (unsigned char)*s >= ' ' && *s != '"' && *s != '\\')
+			p = put_char(p, e, *s++);
+		if (s == short_end) {
+			char const *special = string_scan(s);
+			size_t len = (size_t)(special - s);
+			if (len && p < e)
+				memcpy(p, s, len < (size_t)(e - p) ? len : (size_t)(e - p));
+			p += len;
+			s = special;
 		}
-		*p++ = '\\';
+		if (!*s)
+			break;
+
+		unsigned int c = (unsigned char)*s;
+		char esc[6] = { '\\', 'u', '0', '0', hex[c >> 4 & 15], hex[c & 15] };
+		int length = 2;
 		switch (c) {
 		case '"':
 		//case '/':
-		case '\\': *p++ = c; continue;
-		case '\b': *p++ = 'b'; continue;
-		case '\f': *p++ = 'f'; continue;
-		case '\n': *p++ = 'n'; continue;
-		case '\r': *p++ = 'r'; continue;
-		case '\t': *p++ = 't'; continue;
+		case '\\': esc[1] = (char)c; break;
+		case '\b': esc[1] = 'b'; break;
+		case '\f': esc[1] = 'f'; break;
+		case '\n': esc[1] = 'n'; break;
+		case '\r': esc[1] = 'r'; break;
+		case '\t': esc[1] = 't'; break;
+		default: length = 6; break;
 		}
-
-		*p++ = 'u';
-		unsigned int uc = c;
-		p[0] = hex[uc >> 12 & 15];
-		p[1] = hex[uc >>  8 & 15];
-		p[2] = hex[uc >>  4 & 15];
-		p[3] = hex[uc >>  0 & 15];
-		p += 4;
+		for (int i = 0; i < length; ++i)
+			p = put_char(p, e, esc[i]);
 	}
 	if (p < e)
 		*p = 0;
@@ -47,62 +66,306 @@ char *string_escape(char *p, char *e, char const *s)
 
 
 /* ------------------------------------------------------------------------ */
-static char *json_to_str(char *p, char *e, jsn_t *root)
+static char *scalar_to_str(char *p, char *e, jsn_t *node)
 {
-	switch (root->type) {
+	switch (node->type) {
 	case JS_UNDEFINED:
-		return p + snprintf(p, (size_t)(e-p), "undefined");
+		return str2buf(p, e, "undefined", 9);
 	case JS_NULL:
-		return p + snprintf(p, (size_t)(e-p), "null");
+		return str2buf(p, e, "null", 4);
 	case JS_BOOLEAN:
-		return p + snprintf(p, (size_t)(e-p), root->data.number ? "true" : "false");
+		return node->data.number ? str2buf(p, e, "true", 4) : str2buf(p, e, "false", 5);
 	case JS_NUMBER:
-		return p + snprintf(p, (size_t)(e-p), JSN_NUMBER_FORMAT, root->data.number);
+		return number2str(p, e, node->data.number);
 #ifdef JSON_FLOATS
 	case JS_FLOAT:
-		return float2str(p, e, root->data.floating);
+		return float2str(p, e, node->data.floating);
 #endif
 	case JS_STRING:
-		if (p < e) *p++ = '"';
-		p = string_escape(p, e, root->data.string);
-		if (p < e) *p++ = '"';
-		break;
-	case JS_OBJECT:
-	case JS_ARRAY:;
-		int is_object = root->type == JS_OBJECT;
-		if (p < e) *p++ = is_object ? '{' : '[';
-		json_foreach(root, index) {
-			jsn_t *node = root + index;
-			if (is_object) {
-				if (p < e) *p++ = '"';
-				p = string_escape(p, e, node->id.string);
-				if (p < e) *p++ = '"';
-				if (p < e) *p++ = ':';
-			}
-			p = json_to_str(p, e, node);
-			if (node->next > 0)
-				if (p < e) *p++ = ',';
-		}
-		if (p < e) *p++ = is_object ? '}' : ']';
-		break;
-#ifdef DEBUG
+		p = put_char(p, e, '"');
+		p = string_escape(p, e, json_unescaped_string(node));
+		return put_char(p, e, '"');
 	default:
-		return p + snprintf(p, (size_t)(e-p), "<<<bad-type-%d>>>", root->type);
+#ifdef DEBUG
+		return p + snprintf(p, p < e ? (size_t)(e-p) : 0, "<<<bad-type-%d>>>", node->type);
+#else
+		return p;
 #endif
 	}
-	if (p < e)
-		*p = 0;
-	return p;
+}
+
+
+/* ------------------------------------------------------------------------ */
+/* iterative: parents of the node are kept in explicit stack limited by JSON_MAX_DEPTH */
+static char *json_to_str(char *p, char *e, jsn_t *node)
+{
+	jsn_t *stack[JSON_MAX_DEPTH];
+	int depth = 0;
+
+	for (;;) {
+		if (node->type == JS_OBJECT || node->type == JS_ARRAY) {
+			p = put_char(p, e, node->type == JS_OBJECT ? '{' : '[');
+			if (node->data.length) {
+				if (depth == JSON_MAX_DEPTH)
+					return errno = ELOOP, NULL;
+				stack[depth++] = node++; /* the first element follows its array/object */
+				goto _element;
+			}
+			p = put_char(p, e, node->type == JS_OBJECT ? '}' : ']');
+		} else
+			p = scalar_to_str(p, e, node);
+
+		/* the node is written, go to the next sibling or close parents */
+		for (;;) {
+			if (!depth) {
+				if (p < e)
+					*p = 0;
+				return p;
+			}
+			jsn_t *parent = stack[depth - 1];
+			if (node->next > 0) {
+				p = put_char(p, e, ',');
+				node = parent + node->next;
+				break;
+			}
+			p = put_char(p, e, parent->type == JS_OBJECT ? '}' : ']');
+			node = parent;
+			--depth;
+		}
+
+_element:
+		if (stack[depth - 1]->type == JS_OBJECT) {
+			p = put_char(p, e, '"');
+			p = string_escape(p, e, json_unescaped_id(node));
+			p = put_char(p, e, '"');
+			p = put_char(p, e, ':');
+		}
+	}
+}
+
+
+/* ------------------------------------------------------------------------ */
+size_t json_stringify_n(char *out, size_t size, jsn_t *root)
+{
+	char *e = size ? out + size - 1 : out; /* keep a byte for terminating zero */
+	char *end = root ? json_to_str(out, e, root) : out;
+	size_t length = end ? (size_t)(end - out) : 0; /* the tree is too deep */
+	if (size)
+		out[length < size ? length : size - 1] = 0;
+	return length;
+}
+
+
+/* ------------------------------------------------------------------------ */
+size_t json_stringify_len(jsn_t *root)
+{
+	char none;
+	return json_stringify_n(&none, 0, root);
 }
 
 
 /* ------------------------------------------------------------------------ */
 char *json_stringify(char *out, size_t size, jsn_t *root)
 {
-	*out = 0;
-	if (root)
-		json_to_str(out, out + size - 1, root);
+	json_stringify_n(out, size, root);
 	return out;
 }
 
+#ifdef JSON_STRINGIFY_STREAM_FN
+
+#if JSON_STRINGIFY_CHUNK_SIZE < 64
+#error "JSON_STRINGIFY_CHUNK_SIZE should fit a scalar value (64 bytes at least)"
+#endif
+
+typedef struct jsn_writer jsn_writer_t;
+
+struct jsn_writer {
+	int (*sink)(jsn_writer_t *w, char const *data, size_t len); /* flushes buf and then data */
+	jsn_write_fn write;
+	void *ctx;
+	int fd;
+	size_t length;
+	char buf[JSON_STRINGIFY_CHUNK_SIZE];
+};
+
+/* ------------------------------------------------------------------------ */
+static int callback_sink(jsn_writer_t *w, char const *data, size_t len)
+{
+	if ((w->length && w->write(w->ctx, w->buf, w->length)) || (len && w->write(w->ctx, data, len)))
+		return errno = ECANCELED, -1;
+	w->length = 0;
+	return 0;
+}
+
+
+/* ------------------------------------------------------------------------ */
+static int fd_sink(jsn_writer_t *w, char const *data, size_t len)
+{
+	struct iovec iov[2] = {
+		{ .iov_base = w->buf, .iov_len = w->length },
+		{ .iov_base = (void *)data, .iov_len = len }
+	};
+	for (struct iovec *v = iov, *end = iov + 2; v < end; ) {
+		if (!v->iov_len) {
+			++v;
+			continue;
+		}
+		ssize_t n = writev(w->fd, v, (int)(end - v));
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		for (; v < end && (size_t)n >= v->iov_len; ++v)
+			n -= v->iov_len;
+		if (v < end) {
+			v->iov_base = (char *)v->iov_base + n;
+			v->iov_len -= n;
+		}
+	}
+	w->length = 0;
+	return 0;
+}
+
+
+/* ------------------------------------------------------------------------ */
+static int writer_put(jsn_writer_t *w, char const *data, size_t len)
+{
+	if (len > sizeof w->buf - w->length) {
+		if (len >= sizeof w->buf / 2)
+			return w->sink(w, data, len); /* long runs are written without copying */
+		if (w->sink(w, NULL, 0))
+			return -1;
+	}
+	memcpy(w->buf + w->length, data, len);
+	w->length += len;
+	return 0;
+}
+
+
+/* ------------------------------------------------------------------------ */
+static inline int writer_char(jsn_writer_t *w, char c)
+{
+	if (w->length == sizeof w->buf && w->sink(w, NULL, 0))
+		return -1;
+	w->buf[w->length++] = c;
+	return 0;
+}
+
+
+/* ------------------------------------------------------------------------ */
+static int writer_string(jsn_writer_t *w, char const *s)
+{
+	char const *special = string_scan(s);
+	size_t len = (size_t)(special - s);
+	if (!*special && len + 2 <= sizeof w->buf - w->length) { /* nothing to escape and fits */
+		char *p = w->buf + w->length;
+		*p = '"';
+		memcpy(p + 1, s, len);
+		p[len + 1] = '"';
+		w->length += len + 2;
+		return 0;
+	}
+
+	if (writer_char(w, '"'))
+		return -1;
+	for (;; special = string_scan(s)) {
+		if (special > s && writer_put(w, s, (size_t)(special - s)))
+			return -1;
+		if (!*special)
+			break;
+		char c[2] = { *special, 0 }, esc[6];
+		if (writer_put(w, esc, (size_t)(string_escape(esc, esc + sizeof esc, c) - esc)))
+			return -1;
+		s = special + 1;
+	}
+	return writer_char(w, '"');
+}
+
+
+/* ------------------------------------------------------------------------ */
+/* the same walk as json_to_str() */
+static int writer_json(jsn_writer_t *w, jsn_t *node)
+{
+	jsn_t *stack[JSON_MAX_DEPTH];
+	int depth = 0;
+
+	for (;;) {
+		if (node->type == JS_OBJECT || node->type == JS_ARRAY) {
+			if (writer_char(w, node->type == JS_OBJECT ? '{' : '['))
+				return -1;
+			if (node->data.length) {
+				if (depth == JSON_MAX_DEPTH)
+					return errno = ELOOP, -1;
+				stack[depth++] = node++;
+				goto _element;
+			}
+			if (writer_char(w, node->type == JS_OBJECT ? '}' : ']'))
+				return -1;
+		} else if (node->type == JS_STRING) {
+			if (writer_string(w, json_unescaped_string(node)))
+				return -1;
+		} else { /* other scalars are not longer than 32 bytes */
+			if (sizeof w->buf - w->length < 32 && w->sink(w, NULL, 0))
+				return -1;
+			char *p = w->buf + w->length;
+			w->length += (size_t)(scalar_to_str(p, p + 32, node) - p);
+		}
+
+		for (;;) {
+			if (!depth)
+				return 0;
+			jsn_t *parent = stack[depth - 1];
+			if (node->next > 0) {
+				if (writer_char(w, ','))
+					return -1;
+				node = parent + node->next;
+				break;
+			}
+			if (writer_char(w, parent->type == JS_OBJECT ? '}' : ']'))
+				return -1;
+			node = parent;
+			--depth;
+		}
+
+_element:
+		if (stack[depth - 1]->type == JS_OBJECT
+				&& (writer_string(w, json_unescaped_id(node)) || writer_char(w, ':')))
+			return -1;
+	}
+}
+
+
+/* ------------------------------------------------------------------------ */
+static int writer_stringify(jsn_writer_t *w, jsn_t *root)
+{
+	w->length = 0;
+	if (root && writer_json(w, root))
+		return -1;
+	return w->length ? w->sink(w, NULL, 0) : 0;
+}
+
+
+/* ------------------------------------------------------------------------ */
+int json_stringify_cb(jsn_write_fn write, void *ctx, jsn_t *root)
+{
+	jsn_writer_t w;
+	w.sink = callback_sink;
+	w.write = write;
+	w.ctx = ctx;
+	return writer_stringify(&w, root);
+}
+
+
+/* ------------------------------------------------------------------------ */
+int json_stringify_fd(int fd, jsn_t *root)
+{
+	jsn_writer_t w;
+	w.sink = fd_sink;
+	w.fd = fd;
+	return writer_stringify(&w, root);
+}
+
+#endif /* JSON_STRINGIFY_STREAM_FN */
+
 #endif /* JSON_STRINGIFY_FN */
@@ -3,6 +3,11 @@
 #include "stdlib.h"
 #include "stdint.h"
 #include "string.h"
+#include "errno.h"
+#include "locale.h"
+#include "unistd.h"
+#include "sys/mman.h"
+#include "pthread.h"
 
 #include "nano/json.h"
 
@@ -11,8 +16,12 @@ enum { T_FAIL = -1, T_OK = 0 };
 /* ------------------------------------------------------------------------ */
 static char *fails[] = {
 	"0b1"
+	,"{\"a\\n\":\"b\",\"c\":[\"d\\\"\",tru]}"
 	,"00xccf"
 	,"\"sdfdsf\\\""
+	,"[1x]"
+	,"\"a\"b"
+	,"[\"a\\\\\"b\"]"
 #ifndef JSON_HEX_NUMBERS
 	,"0x5"
 	,"0xccf"
@@ -29,9 +38,12 @@ static int test_fail(char const *source)
 	char *text = strdup(source);
 	int p = json_parse(json, 100, text);
 	if (p <= 0) {
+		int corrupted = strcmp(text, source);
+		if (corrupted)
+			printf("    <<<%s>>> -> <<<%s>>> text is corrupted [FAILED]\n", source, text);
 		free(text);
 		//printf("    [OK]\n");
-		return T_OK;
+		return corrupted ? T_FAIL : T_OK;
 	}
 	size_t length = strlen(source) * 3 + 10;
 	char *result = malloc(length);
@@ -78,18 +90,40 @@ static char *good[] = {
 	,"\"русские буквы\"", "\"русские буквы\""
 //	,"\"\\u0080\\u0091\\u009a\\u009E\\u009f\"", "\"\\u0080\\u0091\\u009a\\u009e\\u009f\""
 	,"\"werw\xbc\001erer\"", "\"werw\xbc\\u0001erer\""
+	,"[\"\\\\\\\\\",\"\\\"\"]", "[\"\\\\\\\\\",\"\\\"\"]"
 	,"1", "1"
 	,"-1", "-1"
+	,"-0", "0"
+	,"[0,7,12345678,-87654321,012]", "[0,7,12345678,-87654321,12]"
 #ifdef JSON_64BITS_INTEGERS
 	,"100000000000", "100000000000"
 	,"-100000000000", "-100000000000"
+	,"9223372036854775807", "9223372036854775807"
+	,"-9223372036854775808", "-9223372036854775808"
+	,"9223372036854775808", "9223372036854775807"
+	,"-9223372036854775809", "-9223372036854775808"
+	,"18446744073709551617", "9223372036854775807"
+	,"-1234567890123456789012", "-9223372036854775808"
 #else
 	,"100000000000", "2147483647"
 	,"-100000000000", "-2147483648"
+	,"2147483647", "2147483647"
+	,"-2147483648", "-2147483648"
+	,"2147483648", "2147483647"
+	,"-2147483649", "-2147483648"
+	,"4294967297", "2147483647"
+	,"-1234567890123456789012", "-2147483648"
 #endif
 #ifdef JSON_HEX_NUMBERS
 	,"0x40", "64"
 	,"-0x100", "-256"
+	,"0x7fffffff", "2147483647"
+	,"-0x00000000000000000001", "-1"
+#ifdef JSON_64BITS_INTEGERS
+	,"0x100000000000000000", "9223372036854775807"
+#else
+	,"0x100000000000000000", "2147483647"
+#endif
 #endif
 	," [ ] ", "[]"
 	,"{} ", "{}"
@@ -145,6 +179,138 @@ static char *good[] = {
 #endif
 };
 
+/* ------------------------------------------------------------------------ */
+/* strings ended right before unmapped page, so reading over the page crashes */
+static int test_page_end()
+{
+	long page = sysconf(_SC_PAGESIZE);
+	char *pages = mmap(NULL, 2 * page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	mprotect(pages + page, page, PROT_NONE);
+
+	int fail = T_OK;
+	for (int len = 0; len < 70; ++len) {
+		char *text = pages + page - len - 3;
+		text[0] = '"';
+		memset(text + 1, 'a', len);
+		strcpy(text + len + 1, "\"");
+		jsn_t json[2];
+		if (string_scan(text + 1) != text + len + 1 || json_parse(json, 2, text) != 1 || strlen(json->data.string) != (size_t)len) {
+			printf("    %d chars string at the page end [FAILED]\n", len);
+			fail = T_FAIL;
+		}
+	}
+	munmap(pages, 2 * page);
+	return fail;
+}
+
+
+/* ------------------------------------------------------------------------ */
+/* quotes after odd and even runs of backslashes at bytes 62-65 of 64 bytes blocks and over several blocks */
+static int test_block_edges()
+{
+	static char text[512] __attribute__((aligned(64)));
+	static int const runs[] = { 0, 1, 2, 3, 4, 5, 63, 64, 65, 66, 129, 130 };
+	int fail = T_OK;
+	for (int at = 60; at < 68; ++at)
+		for (size_t r = 0; r < sizeof runs / sizeof runs[0]; ++r) {
+			int n = runs[r], pad = at - n - 2; /* the quote after the run is at byte 'at' */
+			pad += pad < 0 ? 128 : 0;
+			char expected[256], *e = expected, *s = text;
+			*s++ = '['; *s++ = '"';
+			for (int i = 0; i < pad; ++i)
+				*s++ = *e++ = 'a' + i % 26;
+			for (int i = 0; i < n; ++i)
+				*s++ = '\\';
+			for (int i = 0; i < n / 2; ++i)
+				*e++ = '\\';
+			*s++ = '"';
+			if (n & 1) {
+				*s = 0;
+				jsn_t json[4];
+				if (json_parse(json, 4, text) > 0) { /* the quote is escaped, the string is not terminated */
+					printf("    escaped quote at %d after %d backslashes [FAILED]\n", at, n);
+					fail = T_FAIL;
+				}
+				*s++ = 'b'; *s++ = '"';
+				*e++ = '"'; *e++ = 'b';
+			}
+			*e = 0;
+			strcpy(s, ",\"x\"]");
+
+			jsn_t json[4];
+			int nodes = json_parse(json, 4, text);
+			if (nodes != 3 || strcmp(json_string(json_cell(json, 0), ""), expected) || strcmp(json_string(json_cell(json, 1), ""), "x")) {
+				printf("    quote at %d after %d backslashes [FAILED] // %d nodes\n", at, n, nodes);
+				fail = T_FAIL;
+			}
+		}
+	return fail;
+}
+
+
+#ifdef JSON_STRINGIFY_STREAM_FN
+/* ------------------------------------------------------------------------ */
+typedef struct {
+	char *text;
+	size_t length, size;
+	int calls, cancel; /* cancel after number of calls */
+} stream_out_t;
+
+static int stream_put(void *ctx, char const *data, size_t len)
+{
+	stream_out_t *out = ctx;
+	if (++out->calls == out->cancel)
+		return 1;
+	if (out->length + len >= out->size)
+		out->text = realloc(out->text, out->size = (out->length + len) * 2 + 1);
+	memcpy(out->text + out->length, data, len);
+	out->text[out->length += len] = 0;
+	return 0;
+}
+
+
+/* ------------------------------------------------------------------------ */
+static int test_stream(jsn_t *json, char const *expected)
+{
+	stream_out_t out = { .text = NULL };
+	int r = json_stringify_cb(stream_put, &out, json);
+	int fail = r || !out.text || strcmp(out.text, expected) ? T_FAIL : T_OK;
+	if (fail)
+		printf("    <%.80s> json_stringify_cb() -> %d <%.80s> [FAILED]\n", expected, r, out.text);
+	free(out.text);
+	return fail;
+}
+#endif
+
+
+/* ------------------------------------------------------------------------ */
+static int test_stringify_n(jsn_t *json, char const *expected)
+{
+	size_t length = strlen(expected);
+	if (json_stringify_len(json) != length) {
+		printf("    <%s> json_stringify_len() -> %u [FAILED]\n", expected, (unsigned int)json_stringify_len(json));
+		return T_FAIL;
+	}
+
+	char result[length + 2];
+	for (size_t size = 0; size <= length + 1; ++size) {
+		memset(result, '#', sizeof result);
+		size_t n = json_stringify_n(result, size, json);
+		size_t written = size ? strlen(result) : 0;
+		if (n != length || (size && (written != (size > length ? length : size - 1) || memcmp(result, expected, written)))
+				|| result[size ? written + 1 : 0] != '#') {
+			printf("    <%s> json_stringify_n(%u) -> %u <%.*s> [FAILED]\n", expected, (unsigned int)size, (unsigned int)n, (int)written, result);
+			return T_FAIL;
+		}
+	}
+#ifdef JSON_STRINGIFY_STREAM_FN
+	return test_stream(json, expected);
+#else
+	return T_OK;
+#endif
+}
+
+
 /* ------------------------------------------------------------------------ */
 static int test_ok(char const *source, char const *expected)
 {
@@ -163,7 +329,7 @@ static int test_ok(char const *source, char const *expected)
 	if (!strcmp(result, expected)) {
 		//printf("    [OK]\n");
 		free(result);
-		return T_OK;
+		return test_stringify_n(json, expected);
 	} else {
 		printf("    <<<%s>>> -> <%s>[%d]\n but expected <%s> [FAILED] // serializing\n", source, result, p, expected);
 	}
@@ -232,6 +398,870 @@ static int test_json_auto_parse()
 
 
 
+#ifdef JSON_SAX_FN
+/* ------------------------------------------------------------------------ */
+typedef
+struct sax_out {
+	char *begin, *ptr, *end;
+	int cancel_at; /* number of events to cancel parsing after (0 - never) */
+} sax_out_t;
+
+static int sax_put(void *ctx, char const *str)
+{
+	sax_out_t *o = (sax_out_t *)ctx;
+	if (o->ptr > o->begin && !strchr("[{:", o->ptr[-1]) && *str != ']' && *str != '}')
+		*o->ptr++ = ',';
+	o->ptr = stpcpy(o->ptr, str);
+	return o->cancel_at && !--o->cancel_at;
+}
+
+static int sax_start_object(void *ctx) { return sax_put(ctx, "{"); }
+static int sax_end_object  (void *ctx) { return sax_put(ctx, "}"); }
+static int sax_start_array (void *ctx) { return sax_put(ctx, "["); }
+static int sax_end_array   (void *ctx) { return sax_put(ctx, "]"); }
+
+static int sax_key(void *ctx, char const *id)
+{
+	char str[256] = "\"";
+	char *e = string_escape(str + 1, str + sizeof str - 3, id);
+	strcpy(e, "\":");
+	return sax_put(ctx, str);
+}
+
+static int sax_value(void *ctx, jsn_t *node)
+{
+	char str[256];
+	json_stringify(str, sizeof str, node);
+	return sax_put(ctx, str);
+}
+
+static int sax_count(void *ctx, jsn_t *node)
+{
+	++*(int *)ctx;
+	return 0;
+}
+
+static jsn_handlers_t const sax_handlers = {
+	.start_object = sax_start_object,
+	.end_object   = sax_end_object,
+	.start_array  = sax_start_array,
+	.end_array    = sax_end_array,
+	.key          = sax_key,
+	.value        = sax_value
+};
+
+
+/* ------------------------------------------------------------------------ */
+static int test_sax(char const *source, char const *expected, int cancel_at)
+{
+	size_t length = strlen(source) * 3 + 10;
+	char *text = strdup(source);
+	sax_out_t out = { .ptr = malloc(length), .cancel_at = cancel_at };
+	out.begin = out.ptr;
+	*out.ptr = 0;
+
+	int fail = T_OK;
+	int p = json_sax_parse(text, &sax_handlers, &out);
+	if (!expected) {
+		if (p > 0) {
+			printf("    <<<%s>>> -> <%s>\n but is should be FAILED\n", source, out.begin);
+			fail = T_FAIL;
+		}
+	} else
+		if (p <= 0) {
+			printf("    <<<%s>>> [FAILED] // parsing %d(%m) '%s'\n", source, -p, text - p);
+			fail = T_FAIL;
+		} else
+			if (strcmp(out.begin, expected)) {
+				printf("    <<<%s>>> -> <%s>\n but expected <%s> [FAILED] // events\n", source, out.begin, expected);
+				fail = T_FAIL;
+			}
+
+	free(out.begin);
+	free(text);
+	return fail;
+}
+
+
+/* ------------------------------------------------------------------------ */
+static int test_json_sax_parse()
+{
+	int fail = T_OK;
+	printf("  Test BROKEN samples\n");
+	for (int i = 0, n = sizeof fails / sizeof fails[0]; i < n; i += 1)
+		fail |= test_sax(fails[i], NULL, 0);
+
+	printf("  Test CORRECT samples\n");
+	for (int i = 0, n = sizeof good / sizeof good[0]; i < n; i += 2)
+		fail |= test_sax(good[i], good[i + 1], 0);
+
+	printf("  Test cancelling\n");
+	fail |= test_sax("{\"a\":[1,2,3]}", NULL, 4);
+
+	char text[] = "[1,[2,{\"b\":3}]]";
+	int values = 0;
+	int p = json_sax_parse(text, &(jsn_handlers_t){ .value = sax_count }, &values);
+	if (p != 6 || values != 3) {
+		printf("    <<<%s>>> -> %d nodes, %d values [FAILED]\n", "[1,[2,{\"b\":3}]]", p, values);
+		fail |= T_FAIL;
+	}
+	return fail;
+}
+#endif
+
+
+#ifdef JSON_FEED_FN
+/* ------------------------------------------------------------------------ */
+/* feeds the stream by chunks of `step` bytes and stringifies every document to `out` separated by spaces */
+static int feed_stream(char const *stream, size_t step, char *out, size_t size)
+{
+	jsn_feed_t feed;
+	json_feed_init(&feed);
+
+	int errors = 0;
+	char *e = out + size;
+	*out = 0;
+	for (size_t left = strlen(stream); ; ) {
+		size_t n = left < step ? left : step, len = n;
+		char buf[64]; /* the chunk is overwritten after every call */
+		char const *chunk = memcpy(buf, stream, n);
+		jsn_t *json = json_parser_feed(&feed, n ? &chunk : NULL, &len);
+		memset(buf, '"', sizeof buf);
+		if (json) {
+			out += strlen(json_stringify(out, e - out, json));
+			out = stpcpy(out, " ");
+		} else
+			if (errno == ENODATA)
+				break;
+			else
+				if (errno != EAGAIN)
+					++errors;
+		stream += n - len;
+		left -= n - len;
+	}
+	json_feed_destroy(&feed);
+	return errors;
+}
+
+
+/* ------------------------------------------------------------------------ */
+static int test_feed()
+{
+	int fail = T_OK;
+	char result[1024], expected[1024];
+
+	printf("  Test CORRECT samples\n");
+	for (int i = 0, n = sizeof good / sizeof good[0]; i < n; i += 2)
+		for (size_t step = 1; step < 8; step += 3) {
+			sprintf(expected, "%s ", good[i + 1]);
+			if (feed_stream(good[i], step, result, sizeof result) || strcmp(result, expected)) {
+				printf("    <<<%s>>> -> <%s> by %d bytes\n but expected <%s> [FAILED]\n", good[i], result, (int)step, good[i + 1]);
+				fail |= T_FAIL;
+			}
+		}
+
+	printf("  Test BROKEN samples\n");
+	for (int i = 0, n = sizeof fails / sizeof fails[0]; i < n; i += 1)
+		if (!feed_stream(fails[i], 2, result, sizeof result)) {
+			printf("    <<<%s>>> -> <%s>\n but is should be FAILED\n", fails[i], result);
+			fail |= T_FAIL;
+		}
+
+	printf("  Test nesting depth\n");
+	char *deep = malloc(JSON_MAX_DEPTH * 2 + 3);
+	memset(deep, '[', JSON_MAX_DEPTH + 1);
+	memset(deep + JSON_MAX_DEPTH + 1, ']', JSON_MAX_DEPTH + 1);
+	deep[JSON_MAX_DEPTH * 2 + 2] = 0;
+	jsn_feed_t feed;
+	json_feed_init(&feed);
+	char const *chunk = deep;
+	size_t len = strlen(deep);
+	if (json_parser_feed(&feed, &chunk, &len) || errno != ELOOP || chunk != deep + JSON_MAX_DEPTH + 1) {
+		printf("    %d nested arrays [FAILED]\n", JSON_MAX_DEPTH + 1);
+		fail |= T_FAIL;
+	}
+	chunk = deep + 1;
+	len = strlen(chunk) - 1;
+	jsn_t *json = json_parser_feed(&feed, &chunk, &len);
+	if (!json || len || json_length(json) != 1) {
+		printf("    %d nested arrays [FAILED]\n", JSON_MAX_DEPTH);
+		fail |= T_FAIL;
+	}
+	free(deep);
+
+	printf("  Test wide objects and long arrays\n");
+	char *wide = malloc(16 << 10), *s = wide;
+	s += sprintf(s, "{\"list\":[");
+	for (int i = 0; i < 100; ++i)
+		s += sprintf(s, i ? ",[%d]" : "[%d]", i);
+	s += sprintf(s, "],\"obj\":{");
+	for (int i = 0; i < 100; ++i)
+		s += sprintf(s, i ? ",\"k%d\":\"v\\u00e9%d\"" : "\"k%d\":\"v\\u00e9%d\"", i, i);
+	sprintf(s, "}}");
+	char *text = strdup(wide);
+	jsn_t *expect = json_auto_parse(text, NULL);
+	char *out = malloc(16 << 10), *exp = malloc(16 << 10);
+	json_stringify(exp, 16 << 10, expect);
+	for (size_t step = 1; step < 200; step += 37) {
+		json = NULL;
+		for (chunk = wide, len = 0; !json && *chunk; len = 0) {
+			len = strlen(chunk) < step ? strlen(chunk) : step;
+			json = json_parser_feed(&feed, &chunk, &len);
+		}
+		if (!json || strcmp(json_stringify(out, 16 << 10, json), exp) || feed.arena.length != json_count_nodes(wide)
+		 || strcmp(json_string(json_item(json_item(json, "obj"), "k77"), ""), "v\xc3\xa9" "77")
+		 || json_number(json_cell(json_cell(json_item(json, "list"), 88), 0), 0) != 88) {
+			printf("    <<<%.64s...>>> by %d bytes [FAILED]\n", wide, (int)step);
+			fail |= T_FAIL;
+		}
+	}
+	json_feed_destroy(&feed);
+	free(exp);
+	free(out);
+	free(expect);
+	free(text);
+	free(wide);
+
+	printf("  Test stream of documents\n");
+	char const *stream = "{\"a\":[1,{}]}[\"]\\\"\"] \"s\"\n12 true{}-3";
+	char const *docs = "{\"a\":[1,{}]} [\"]\\\"\"] \"s\" 12 true {} -3 ";
+	for (size_t step = 1; step < 40; step += 5)
+		if (feed_stream(stream, step, result, sizeof result) || strcmp(result, docs)) {
+			printf("    <<<%s>>> -> <%s> by %d bytes\n but expected <%s> [FAILED]\n", stream, result, (int)step, docs);
+			fail |= T_FAIL;
+		}
+
+	return fail;
+}
+#endif
+
+
+#ifdef JSON_PARSE_NEXT_FN
+/* ------------------------------------------------------------------------ */
+/* parses concatenated documents of `source` one by one, stringified separated by spaces to `out` */
+static int parse_next(char const *source, int arena, char *out, size_t size)
+{
+	char *text = strdup(source), *e = out + size;
+	jsn_t pool[100];
+#if defined(JSON_ARENA_FN) || defined(JSON_FEED_FN)
+	jsn_arena_t a;
+	json_arena_init(&a);
+#endif
+
+	int errors = 0;
+	*out = 0;
+	for (char *s = text, *next; ; s = next) {
+		jsn_t *json = pool;
+#if defined(JSON_ARENA_FN) || defined(JSON_FEED_FN)
+		if (arena)
+			json = json_arena_parse_next(&a, s, &next);
+		else
+#endif
+			if (json_parse_next(pool, sizeof pool / sizeof pool[0], s, &next) <= 0)
+				json = NULL;
+		if (json) {
+			out += strlen(json_stringify(out, e - out, json));
+			out = stpcpy(out, " ");
+		} else {
+			if (errno != ENODATA || *next)
+				++errors;
+			break;
+		}
+	}
+#if defined(JSON_ARENA_FN) || defined(JSON_FEED_FN)
+	json_arena_destroy(&a);
+#endif
+	free(text);
+	return errors;
+}
+
+
+/* ------------------------------------------------------------------------ */
+static int test_parse_next()
+{
+	int fail = T_OK;
+	char result[1024], expected[1024];
+
+#if defined(JSON_ARENA_FN) || defined(JSON_FEED_FN)
+	int arenas = 2;
+#else
+	int arenas = 1;
+#endif
+	for (int arena = 0; arena < arenas; ++arena) {
+		for (int i = 0, n = sizeof good / sizeof good[0]; i < n; i += 2) {
+			sprintf(expected, "%s ", good[i + 1]);
+			if (parse_next(good[i], arena, result, sizeof result) || strcmp(result, expected)) {
+				printf("    <<<%s>>> -> <%s>\n but expected <%s> [FAILED] // %s\n", good[i], result, good[i + 1], arena ? "json_arena_parse_next" : "json_parse_next");
+				fail |= T_FAIL;
+			}
+		}
+
+		char const *stream = " {\"a\":[1,{}]}[\"]\\\"\"] \"s\"\n12 true{}-3\t";
+		char const *docs = "{\"a\":[1,{}]} [\"]\\\"\"] \"s\" 12 true {} -3 ";
+		if (parse_next(stream, arena, result, sizeof result) || strcmp(result, docs)) {
+			printf("    <<<%s>>> -> <%s>\n but expected <%s> [FAILED]\n", stream, result, docs);
+			fail |= T_FAIL;
+		}
+
+		char const *broken = "[1] {\"a\":2} [3,";
+		if (parse_next(broken, arena, result, sizeof result) != 1 || strcmp(result, "[1] {\"a\":2} ")) {
+			printf("    <<<%s>>> -> <%s> [FAILED] // should fail at the third document\n", broken, result);
+			fail |= T_FAIL;
+		}
+	}
+
+	jsn_t pool[2];
+	char text[] = "[1,2] 3", *next;
+	errno = 0;
+	if (json_parse_next(pool, 2, text, &next) > 0 || errno != ENOMEM) {
+		printf("    small pool [FAILED]\n");
+		fail |= T_FAIL;
+	}
+	char spaces[] = " \r\n";
+	errno = 0;
+	if (json_parse_next(pool, 2, spaces, &next) || errno != ENODATA || next != spaces + 3) {
+		printf("    empty text [FAILED]\n");
+		fail |= T_FAIL;
+	}
+	return fail;
+}
+#endif
+
+
+#ifdef JSON_NDJSON_FN
+/* ------------------------------------------------------------------------ */
+/* lines of good samples with broken and blank ones, parsed by every number of threads */
+static int test_ndjson()
+{
+	int fail = T_OK;
+	size_t ngood = sizeof good / sizeof good[0] / 2, nfails = sizeof fails / sizeof fails[0];
+	size_t records = 0, size = 1;
+	char const **expected = malloc(ngood * 20 * 2 * sizeof(char *));
+	for (int pass = 0; pass < 2; ++pass) {
+		char *text = pass ? malloc(size) : NULL, *t = text;
+		records = 0;
+		for (size_t k = 0; k < 20 * ngood; ++k) {
+			char const *line = good[k % ngood * 2];
+			if (strchr(line, '\n'))
+				continue;
+			if (pass) {
+				t += sprintf(t, k % 5 ? "%s\n" : "%s\r\n \t\n", line);
+				expected[records] = good[k % ngood * 2 + 1];
+			}
+			size += strlen(line) + 5;
+			++records;
+			if (k % 7 || strchr(fails[k % nfails], '\n'))
+				continue;
+			if (pass) {
+				t += sprintf(t, "%s\n", fails[k % nfails]);
+				expected[records] = NULL;
+			}
+			size += strlen(fails[k % nfails]) + 1;
+			++records;
+		}
+		if (!pass)
+			continue;
+
+		for (int threads = 0; threads < 5; ++threads) {
+			char *copy = strdup(text);
+			jsn_ndjson_t docs;
+			int n = json_ndjson_parse(&docs, copy, threads);
+			if (docs.length != records || n != (int)(docs.length - docs.failures) || docs.threads < 1) {
+				printf("    %d threads: %d of %u records [FAILED]\n", threads, n, (unsigned int)docs.length);
+				fail |= T_FAIL;
+			} else
+				for (size_t i = 0; i < records; ++i) {
+					char result[1024];
+					if (!expected[i] != !docs.roots[i] || (docs.roots[i] && strcmp(json_stringify(result, sizeof result, docs.roots[i]), expected[i]))) {
+						printf("    %d threads: record %u <%s> but expected <%s> [FAILED]\n", threads, (unsigned int)i,
+							docs.roots[i] ? result : "FAILED", expected[i] ? expected[i] : "FAILED");
+						fail |= T_FAIL;
+						break;
+					}
+				}
+			json_ndjson_free(&docs);
+			free(copy);
+		}
+		free(text);
+	}
+	free(expected);
+
+	jsn_ndjson_t docs;
+	char blank[] = " \n\n\r\n";
+	if (json_ndjson_parse(&docs, blank, 4) != 0 || docs.length || docs.failures) {
+		printf("    blank lines [FAILED]\n");
+		fail |= T_FAIL;
+	}
+	json_ndjson_free(&docs);
+	return fail;
+}
+#endif
+
+
+#ifdef JSON_PARSE_N_FN
+/* ------------------------------------------------------------------------ */
+/* parses read only copy of source ended right before unmapped page, so any overrun or write crashes */
+static int parse_n(char const *source, char *result, size_t size)
+{
+	static char *pages = NULL;
+	long page = sysconf(_SC_PAGESIZE);
+	if (!pages) {
+		pages = mmap(NULL, 2 * page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		mprotect(pages + page, page, PROT_NONE);
+	}
+
+	size_t len = strlen(source);
+	char *text = pages + page - len;
+	mprotect(pages, page, PROT_READ | PROT_WRITE);
+	memcpy(text, source, len);
+	mprotect(pages, page, PROT_READ);
+
+	jsn_t json[100];
+	char strings[1024];
+	int p = json_parse_n(json, 100, text, len, strings, sizeof strings);
+	if (p > 0)
+		json_stringify(result, size, json);
+	return p;
+}
+
+
+/* ------------------------------------------------------------------------ */
+static int test_json_parse_n()
+{
+	int fail = T_OK;
+	char result[1024];
+
+	printf("  Test BROKEN samples\n");
+	for (int i = 0, n = sizeof fails / sizeof fails[0]; i < n; i += 1)
+		if (parse_n(fails[i], result, sizeof result) > 0) {
+			printf("    <<<%s>>> -> <%s>\n but is should be FAILED\n", fails[i], result);
+			fail |= T_FAIL;
+		}
+
+	char const *truncated[] = { "[1", "\"abc", "\"abc\\\"", "{\"a\":tru", "nul", "[1,", "{\"a\"", "  " };
+	for (int i = 0, n = sizeof truncated / sizeof truncated[0]; i < n; i += 1)
+		if (parse_n(truncated[i], result, sizeof result) > 0) {
+			printf("    <<<%s>>> -> <%s>\n but is should be FAILED\n", truncated[i], result);
+			fail |= T_FAIL;
+		}
+
+	printf("  Test CORRECT samples\n");
+	for (int i = 0, n = sizeof good / sizeof good[0]; i < n; i += 2) {
+		int p = parse_n(good[i], result, sizeof result);
+		if (p <= 0) {
+			printf("    <<<%s>>> [FAILED] // parsing %d(%m)\n", good[i], -p);
+			fail |= T_FAIL;
+		} else
+			if (strcmp(result, good[i + 1])) {
+				printf("    <<<%s>>> -> <%s>\n but expected <%s> [FAILED] // serializing\n", good[i], result, good[i + 1]);
+				fail |= T_FAIL;
+			}
+	}
+
+	printf("  Test long numbers\n");
+	char number[256], source[300];
+#ifdef JSON_FLOATS
+	for (int i = 0; i < 4; ++i) {
+#else
+	for (int i = 0; i < 2; ++i) {
+#endif
+		char *d = number;
+		d += sprintf(d, i & 1 ? "-" : "");
+		for (int k = 0; k < 150; ++k)
+			*d++ = '1' + k % 9;
+		sprintf(d, i & 2 ? ".%047de-250" : "", 5); /* 203 chars float */
+		sprintf(source, i & 1 ? "[%s]" : "%s", number);
+
+		jsn_t json[4];
+		char expected[1024], *copy = strdup(source);
+		int p = json_parse(json, 4, copy);
+		if (p > 0)
+			json_stringify(expected, sizeof expected, json);
+		free(copy);
+		if (p <= 0 || parse_n(source, result, sizeof result) != p || strcmp(result, expected)) {
+			printf("    <<<%s>>> [FAILED] // json_parse() %d\n", source, p);
+			fail |= T_FAIL;
+		}
+	}
+
+	printf("  Test small strings buffer\n");
+	char text[] = "[\"abc\",\"d\\u0065f\"]";
+	jsn_t json[8];
+	char strings[14]; /* "abc" takes 4 bytes, "d\u0065f" needs 9 free bytes to be unescaped */
+	int size = 13;
+	if (json_parse_n(json, 8, text, sizeof text - 1, strings, size - 1) > 0 || errno != ENOBUFS
+	 || json_parse_n(json, 8, text, sizeof text - 1, strings, size) <= 0 || strcmp(json_string(json + 2, ""), "def")) {
+		printf("    <<<%s>>> [FAILED]\n", text);
+		fail |= T_FAIL;
+	}
+	return fail;
+}
+#endif
+
+
+/* ------------------------------------------------------------------------ */
+static int test_count(char const *source)
+{
+	jsn_t json[100];
+	char *text = strdup(source);
+	int count = json_count_nodes(text);
+	int p = json_parse(json, 100, text);
+	free(text);
+	if (count == p)
+		return T_OK;
+
+	printf("    <<<%s>>> -> %d but expected %d [FAILED] // json_count_nodes\n", source, count, p);
+	return T_FAIL;
+}
+
+
+/* ------------------------------------------------------------------------ */
+static int test_json_count_nodes()
+{
+	int fail = T_OK;
+	printf("  Test BROKEN samples\n");
+	for (int i = 0, n = sizeof fails / sizeof fails[0]; i < n; i += 1)
+		fail |= test_count(fails[i]);
+
+	printf("  Test CORRECT samples\n");
+	for (int i = 0, n = sizeof good / sizeof good[0]; i < n; i += 2)
+		fail |= test_count(good[i]);
+
+	return fail;
+}
+
+
+/* ------------------------------------------------------------------------ */
+static int test_long_strings()
+{
+	int fail = T_OK;
+	for (int pad = 0; pad < 33; ++pad)
+		for (int len = 0; len < 70; ++len) {
+			char source[256], expected[256];
+			char *s = source, *e = expected;
+			for (int i = 0; i < pad; ++i)
+				*s++ = i & 1 ? '\n' : ' ';
+			*s++ = '"'; *e++ = '"';
+			for (int i = 0; i < len; ++i) {
+				if (i == len / 2 && len % 3 == 0) {
+					*s++ = '\\'; *s++ = 'n';
+					*e++ = '\\'; *e++ = 'n';
+				}
+				*s++ = *e++ = 'a' + i % 26;
+			}
+			*s++ = '"'; *e++ = '"';
+			for (int i = 0; i < pad; ++i)
+				*s++ = ' ';
+			*s = *e = 0;
+			fail |= test_ok(source, expected);
+		}
+
+	return fail;
+}
+
+
+#ifdef JSON_STRINGIFY_STREAM_FN
+/* ------------------------------------------------------------------------ */
+static int test_stringify_stream()
+{
+	/* strings of 0..5000 chars with escapes are longer than the writer buffer */
+	size_t size = 1 << 20;
+	char *text = malloc(size), *t = text;
+	*t++ = '[';
+	for (int i = 0; i < 300; ++i) {
+		t += sprintf(t, i ? ",{\"s%d\":\"" : "{\"s%d\":\"", i);
+		for (int j = 0, len = i * 17 % 5000; j < len; ++j)
+			if (j % 1000 == 999)
+				t += sprintf(t, "\\u00%02x", j % 32);
+			else
+				*t++ = 'a' + j % 26;
+		t += sprintf(t, "\",\"n\":[%d,true,null]}", i);
+	}
+	strcpy(t, "]");
+
+	int fail = T_OK;
+	jsn_t *json = json_auto_parse(text, NULL);
+	size_t length = json ? json_stringify_len(json) : 0;
+	char *expected = malloc(length + 1);
+	if (!json || json_stringify_n(expected, length + 1, json) != length) {
+		printf("    json_auto_parse() [FAILED]\n");
+		free(expected);
+		free(text);
+		free(json);
+		return T_FAIL;
+	}
+
+	fail |= test_stream(json, expected);
+
+	FILE *f = tmpfile();
+	char *result = malloc(length + 2);
+	if (json_stringify_fd(fileno(f), json) || lseek(fileno(f), 0, SEEK_SET)
+			|| read(fileno(f), result, length + 1) != (ssize_t)length || memcmp(result, expected, length)) {
+		printf("    json_stringify_fd() [FAILED]\n");
+		fail |= T_FAIL;
+	}
+	fclose(f);
+
+	if (json_stringify_fd(-1, json) != -1 || errno != EBADF) {
+		printf("    json_stringify_fd(-1) [FAILED]\n");
+		fail |= T_FAIL;
+	}
+
+	stream_out_t out = { .text = NULL, .cancel = 2 };
+	if (json_stringify_cb(stream_put, &out, json) != -1 || errno != ECANCELED || out.calls != 2) {
+		printf("    json_stringify_cb() cancel [FAILED]\n");
+		fail |= T_FAIL;
+	}
+	free(out.text);
+
+	free(result);
+	free(expected);
+	free(json);
+	free(text);
+	return fail;
+}
+#endif
+
+
+/* ------------------------------------------------------------------------ */
+static char *nested_text(int depth)
+{
+	char *text = malloc(depth * 6 + 2), *t = text;
+	for (int i = 0; i < depth; ++i)
+		t += sprintf(t, i & 1 ? "{\"a\":" : "[");
+	*t++ = '1';
+	for (int i = depth - 1; i >= 0; --i)
+		*t++ = i & 1 ? '}' : ']';
+	*t = 0;
+	return text;
+}
+
+
+/* ------------------------------------------------------------------------ */
+static int test_depth()
+{
+	int fail = T_OK;
+	int nodes = JSON_MAX_DEPTH + 1;
+	jsn_t *json = malloc((nodes + 1) * sizeof(jsn_t));
+
+	char *text = nested_text(JSON_MAX_DEPTH), *source = strdup(text);
+	if (json_count_nodes(text) != nodes || json_parse(json, nodes, text) != nodes) {
+		printf("    %d levels [FAILED] // parsing (%m)\n", JSON_MAX_DEPTH);
+		fail |= T_FAIL;
+	} else {
+		size_t length = strlen(source);
+		char *result = malloc(length + 1);
+		if (json_stringify_n(result, length + 1, json) != length || strcmp(result, source)) {
+			printf("    %d levels [FAILED] // serializing\n", JSON_MAX_DEPTH);
+			fail |= T_FAIL;
+		}
+		free(result);
+#ifdef JSON_STRINGIFY_STREAM_FN
+		fail |= test_stream(json, source);
+#endif
+	}
+	free(source);
+	free(text);
+
+	text = nested_text(JSON_MAX_DEPTH + 1);
+	source = strdup(text);
+	errno = 0;
+	if (json_parse(json, nodes + 1, text) > 0 || errno != ELOOP || strcmp(text, source)) {
+		printf("    %d levels [FAILED] // should fail by ELOOP (%m)\n", JSON_MAX_DEPTH + 1);
+		fail |= T_FAIL;
+	}
+	errno = 0;
+	if (json_count_nodes(text) > 0 || errno != ELOOP) {
+		printf("    %d levels [FAILED] // json_count_nodes() should fail by ELOOP (%m)\n", JSON_MAX_DEPTH + 1);
+		fail |= T_FAIL;
+	}
+#ifdef JSON_SAX_FN
+	jsn_handlers_t none = { .value = NULL };
+	errno = 0;
+	if (json_sax_parse(text, &none, NULL) > 0 || errno != ELOOP) {
+		printf("    %d levels [FAILED] // json_sax_parse() should fail by ELOOP (%m)\n", JSON_MAX_DEPTH + 1);
+		fail |= T_FAIL;
+	}
+#endif
+	free(source);
+	free(text);
+
+	/* a tree built by hand is deeper than the limit */
+	for (int i = 0; i <= nodes; ++i) {
+		json[i].next = 0;
+		json[i].id_type = JS_NUMBER;
+		json[i].id.number = 0;
+		json[i].type = i < nodes ? JS_ARRAY : JS_NUMBER;
+		json[i].data.number = 1;
+		if (i < nodes) {
+			json[i].data.length = 1;
+#if defined(JSON_HASH_INDEX) || defined(JSON_ARRAY_INDEX)
+			json[i].data.index = 0;
+#endif
+		}
+	}
+	char buf[16] = "#";
+	errno = 0;
+	if (json_stringify_n(buf, sizeof buf, json) || errno != ELOOP || *buf || json_stringify_len(json)) {
+		printf("    %d levels tree [FAILED] // json_stringify() should fail by ELOOP (%m)\n", nodes);
+		fail |= T_FAIL;
+	}
+#ifdef JSON_STRINGIFY_STREAM_FN
+	stream_out_t out = { .text = NULL };
+	errno = 0;
+	if (json_stringify_cb(stream_put, &out, json) != -1 || errno != ELOOP) {
+		printf("    %d levels tree [FAILED] // json_stringify_cb() should fail by ELOOP (%m)\n", nodes);
+		fail |= T_FAIL;
+	}
+	free(out.text);
+#endif
+
+	free(json);
+	return fail;
+}
+
+
+#ifdef JSON_ARENA_FN
+/* ------------------------------------------------------------------------ */
+static int test_arena()
+{
+	int fail = T_OK;
+	jsn_arena_t arena;
+	json_arena_init(&arena);
+
+	for (int pass = 0; pass < 2; ++pass) {
+		jsn_t *pool = arena.pool;
+		for (int i = 0, n = sizeof good / sizeof good[0]; i < n; i += 2) {
+			char *text = strdup(good[i]);
+			jsn_t *json = json_arena_parse(&arena, text, NULL);
+			char result[2048];
+			if (!json) {
+				printf("    <<<%s>>> [FAILED] // parsing %m\n", good[i]);
+				fail |= T_FAIL;
+			} else
+				if (strcmp(json_stringify(result, sizeof result, json), good[i + 1])) {
+					printf("    <<<%s>>> -> <%s>\n but expected <%s> [FAILED] // serializing\n", good[i], result, good[i + 1]);
+					fail |= T_FAIL;
+				}
+			free(text);
+		}
+		for (int i = 0, n = sizeof fails / sizeof fails[0]; i < n; i += 1) {
+			char *text = strdup(fails[i]);
+			if (json_arena_parse(&arena, text, NULL)) {
+				printf("    <<<%s>>> but is should be FAILED\n", fails[i]);
+				fail |= T_FAIL;
+			}
+			free(text);
+		}
+		if (pass && pool != arena.pool) {
+			printf("    arena pool is reallocated by the second pass [FAILED]\n");
+			fail |= T_FAIL;
+		}
+		json_arena_reset(&arena);
+	}
+
+	json_arena_destroy(&arena);
+	return fail;
+}
+#endif
+
+#ifdef JSON_STATS
+
+/* ------------------------------------------------------------------------ */
+static int stats_hook_calls, stats_hook_result;
+
+static void stats_hook(jsn_stats_t *stats, int result)
+{
+	++stats_hook_calls;
+	stats_hook_result = result;
+}
+
+
+/* ------------------------------------------------------------------------ */
+static int test_stats()
+{
+	int fail = T_OK;
+	jsn_stats_t stats = { .hook = stats_hook };
+	if (json_stats(&stats)) {
+		printf("    json_stats() previous stats [FAILED]\n");
+		fail |= T_FAIL;
+	}
+
+	char text[] = "{\"a\":[1,\"x\\ny\",true,null],\"bc\":{\"d\":\"e\"}}";
+	jsn_t json[16];
+	int len = json_parse(json, 16, text);
+	if (len != 8 || stats.parses != 1 || stats.failures || stats_hook_calls != 1 || stats_hook_result != 8) {
+		printf("    parses %lu/%lu hook %d(%d) [FAILED]\n", stats.parses, stats.failures, stats_hook_calls, stats_hook_result);
+		fail |= T_FAIL;
+	}
+	if (stats.nodes[JS_OBJECT] != 2 || stats.nodes[JS_ARRAY] != 1 || stats.nodes[JS_NUMBER] != 1 || stats.nodes[JS_STRING] != 2 ||
+		stats.nodes[JS_BOOLEAN] != 1 || stats.nodes[JS_NULL] != 1) {
+		printf("    nodes by type [FAILED]\n");
+		fail |= T_FAIL;
+	}
+	if (stats.strings != 5 || stats.escaped != 1 || stats.string_bytes != 9 || stats.max_depth != 2 || stats.max_nodes != 8) {
+		printf("    strings %lu escaped %lu bytes %lu depth %d nodes %d [FAILED]\n",
+			stats.strings, stats.escaped, stats.string_bytes, stats.max_depth, stats.max_nodes);
+		fail |= T_FAIL;
+	}
+
+	char broken[] = "[1,";
+	if (json_parse(json, 16, broken) > 0 || stats.parses != 2 || stats.failures != 1 || stats_hook_calls != 2 || stats_hook_result > 0) {
+		printf("    failed parse [FAILED]\n");
+		fail |= T_FAIL;
+	}
+	if (json_count_nodes("[1,2]") != 3 || stats.parses != 2) {
+		printf("    json_count_nodes() is counted [FAILED]\n");
+		fail |= T_FAIL;
+	}
+
+#if defined(JSON_AUTO_PARSE_FN) && !defined(JSON_AUTO_PARSE_COUNT)
+	int cells = JSON_AUTO_PARSE_POOL_START_SIZE * 2;
+	char *array = malloc(cells * 2 + 2), *t = array;
+	for (int i = 0; i < cells; ++i)
+		t += sprintf(t, i ? ",0" : "[0");
+	strcpy(t, "]");
+	jsn_t *pool = json_auto_parse(array, NULL);
+	if (!pool || !stats.reallocs || stats.max_nodes != cells + 1) {
+		printf("    json_auto_parse() reallocs %lu nodes %d [FAILED]\n", stats.reallocs, stats.max_nodes);
+		fail |= T_FAIL;
+	}
+	free(pool);
+	free(array);
+#endif
+
+#ifdef JSON_NDJSON_FN
+	/* records of the worker threads are counted to the caller's stats, the hook is called once */
+	jsn_stats_t ndjson = { .hook = stats_hook };
+	json_stats(&ndjson);
+	char lines[] = "[1,2]\n{\"a\":\"b\"}\n[1,\n\"s\"\n[[[0]]]\n";
+	jsn_ndjson_t docs;
+	int calls = stats_hook_calls;
+	if (json_ndjson_parse(&docs, lines, 4) != 4 || ndjson.parses != 5 || ndjson.failures != 1 || ndjson.max_depth != 3
+	 || ndjson.nodes[JS_NUMBER] != 4 || ndjson.strings != 3 || stats_hook_calls != calls + 1 || stats_hook_result != 4) {
+		printf("    json_ndjson_parse() parses %lu/%lu depth %d hook %d(%d) [FAILED]\n",
+			ndjson.parses, ndjson.failures, ndjson.max_depth, stats_hook_calls - calls, stats_hook_result);
+		fail |= T_FAIL;
+	}
+	json_ndjson_free(&docs);
+	json_stats(&stats);
+#endif
+
+	if (json_stats(NULL) != &stats) {
+		printf("    json_stats(NULL) [FAILED]\n");
+		fail |= T_FAIL;
+	}
+	unsigned long parses = stats.parses;
+	char more[] = "[]";
+	if (json_parse(json, 16, more) != 1 || stats.parses != parses) {
+		printf("    stopped stats [FAILED]\n");
+		fail |= T_FAIL;
+	}
+	return fail;
+}
+#endif
+
+
 /* ------------------------------------------------------------------------ */
 static int test_gets()
 {
@@ -344,6 +1374,8 @@ static int test_number()
 		,{ "false", 0 }
 		,{ "\"\"", 0 }
 		,{ "\"123\"", 123 }
+		,{ "\" 42\"", 42 }
+		,{ "\"\\t\\n -7\"", -7 }
 #ifdef JSON_64BITS_INTEGERS
 		,{ "100000000000", 100000000000 }
 		,{ "4294967296", 4294967296 }
@@ -382,70 +1414,274 @@ static int test_number()
 			continue;
 		}
 
-		printf("<<<%s>>> -> %d but expected %d [FAILED] // json_number\n", source, result, expected);
-		fail |= T_FAIL;
+		printf("<<<%s>>> -> %d but expected %d [FAILED] // json_number\n", source, result, expected);
+		fail |= T_FAIL;
+	}
+
+	return fail;
+}
+
+
+#ifdef JSON_FLOATS
+/* ------------------------------------------------------------------------ */
+static int test_float()
+{
+	static const struct {
+		char const *text;
+		double floating;
+	} samples[] = {
+		 { "0", 0.d }
+		,{ "1", 1.d }
+		,{ "555", 555.d }
+		,{ "null", 0.d }
+		,{ "true", 1.d }
+		,{ "false", 0.d }
+		,{ "\"\"", 0.d }
+		,{ "\"123\"", 123.d }
+		,{ "\" 42\"", 42.d }
+		,{ "\"\\t\\n -0.5\"", -0.5 }
+#ifdef JSON_64BITS_INTEGERS
+		,{ "100000000000", 100000000000.d }
+#else
+		,{ "100000000000", 2147483647.d }
+#endif
+		,{ "1e4", 1e4 }
+		,{ "1.5", 1.5 }
+		,{ "-0.25", -0.25 }
+		,{ "0.1", 0.1 }
+		,{ "0.000123", 0.000123 }
+		,{ "37.371991", 37.371991 }
+		,{ "-122.026020", -122.026020 }
+		,{ "1.5e25", 1.5e25 }
+		,{ "9007199254740993.0", 9007199254740993.0 }
+		,{ "123456789012345678901234567890.5", 123456789012345678901234567890.5 }
+		,{ "1.7976931348623157e308", 1.7976931348623157e308 }
+		,{ "2.2250738585072014e-308", 2.2250738585072014e-308 }
+		,{ "4.9406564584124654e-324", 4.9406564584124654e-324 }
+		,{ "0.0e99999", 0.d }
+		,{ "1e-99999", 0.d }
+#ifdef JSON_HEX_NUMBERS
+		,{ "\"0x123\"", 291.d }
+#endif
+		,{ "[]", 0.d }
+		,{ "[1]", 1.d }
+		,{ "{}", 0.d }
+	};
+
+	int fail = T_OK;
+	for (int i = 0, n = sizeof samples / sizeof samples[0]; i < n; ++i) {
+		char text[256];
+		char const *source = samples[i].text;
+		jsn_t json[5];
+		strcpy(text, source);
+		int p = json_parse(json, sizeof json / sizeof json[0], text);
+		if (p <= 0) {
+			printf("<<<%s>>> [FAILED] // parsing %d\n", source, -p);
+			fail |= T_FAIL;
+		}
+
+		double result = json_float(json, 0.d);
+		double expected = samples[i].floating;
+		if (result == expected) {
+			//printf("[OK]\n");
+			continue;
+		}
+
+		printf("<<<%s>>> -> %f but expected %f [FAILED] // json_float\n", source, result, expected);
+		fail |= T_FAIL;
+	}
+
+	return fail;
+}
+
+
+/* ------------------------------------------------------------------------ */
+static int test_float2str()
+{
+	static const struct {
+		double floating;
+		char const *string;
+	} samples[] = {
+		 { 0.d, "0.0" }
+		,{ -0.d, "-0.0" }
+		,{ 0.1, "0.1" }
+		,{ 1.5, "1.5" }
+		,{ -0.25, "-0.25" }
+		,{ 1e4, "10000.0" }
+		,{ 37.371991, "37.371991" }
+		,{ -122.02602, "-122.02602" }
+		,{ 123456789.125, "123456789.125" }
+		,{ 0.000001, "0.000001" }
+		,{ 1.5e-7, "1.5e-7" }
+		,{ 1e-11, "1e-11" }
+		,{ 1e20, "100000000000000000000.0" }
+		,{ 1e21, "1e21" }
+		,{ 1.25e300, "1.25e300" }
+		,{ 1.7976931348623157e308, "1.7976931348623157e308" }
+		,{ 2.2250738585072014e-308, "2.2250738585072014e-308" }
+		,{ 4.9406564584124654e-324, "5e-324" }
+		,{ -1.2345678901234567e-6, "-0.0000012345678901234567" }
+	};
+
+	int fail = T_OK;
+	char buf[32];
+	for (int i = 0, n = sizeof samples / sizeof samples[0]; i < n; ++i) {
+		char *e = float2str(buf, buf + sizeof buf, samples[i].floating);
+		if (strcmp(buf, samples[i].string) || e != buf + strlen(buf)) {
+			printf("%.17g -> <%s> but expected <%s> [FAILED] // float2str\n", samples[i].floating, buf, samples[i].string);
+			fail |= T_FAIL;
+		}
+	}
+
+	uint64_t const specials[] = { 0x7FF0000000000000ull, 0xFFF0000000000000ull, 0x7FF8000000000000ull };
+	for (int i = 0; i < 3; ++i) {
+		double d;
+		memcpy(&d, specials + i, sizeof d);
+		float2str(buf, buf + sizeof buf, d);
+		if (strcmp(buf, "null")) {
+			printf("%016llx -> <%s> but expected <null> [FAILED] // float2str\n", (unsigned long long)specials[i], buf);
+			fail |= T_FAIL;
+		}
+	}
+
+	memset(buf, '#', sizeof buf);
+	if (float2str(buf, buf + 4, 0.125) != buf + 5 || memcmp(buf, "0.12#", 5)) {
+		printf("<%.5s> but expected <0.12#> [FAILED] // float2str truncation\n", buf);
+		fail |= T_FAIL;
+	}
+
+	/* round trip of random doubles */
+	unsigned int seed = 2;
+	for (int i = 0; i < 100000 && fail == T_OK; ++i) {
+		uint64_t bits = (uint64_t)rand_r(&seed) << 33 ^ (uint64_t)rand_r(&seed) << 11 ^ rand_r(&seed);
+		if ((bits >> 52 & 0x7ff) == 0x7ff)
+			continue;
+		double d, r;
+		memcpy(&d, &bits, sizeof d);
+		float2str(buf, buf + sizeof buf, d);
+		r = strtod(buf, NULL);
+		if (memcmp(&d, &r, sizeof d)) {
+			printf("%.17g -> <%s> [FAILED] // float2str round trip\n", d, buf);
+			fail |= T_FAIL;
+		}
+	}
+
+	return fail;
+}
+
+/* ------------------------------------------------------------------------ */
+static int float_compare(char const *source)
+{
+	char text[64];
+	jsn_t json[1];
+	strcpy(text, source);
+	double expected = strtod(source, NULL);
+	if (json_parse(json, 1, text) != 1 || json->type != JS_FLOAT) {
+		printf("<<<%s>>> [FAILED] // parsing\n", source);
+		return T_FAIL;
+	}
+	if (memcmp(&json->data.floating, &expected, sizeof expected)) {
+		printf("<<<%s>>> -> %.17g but expected %.17g [FAILED] // not exact\n", source, json->data.floating, expected);
+		return T_FAIL;
+	}
+	return T_OK;
+}
+
+/* ------------------------------------------------------------------------ */
+static int test_float_exact()
+{
+	int fail = T_OK;
+	unsigned int seed = 1;
+	for (int i = 0; i < 100000 && fail == T_OK; ++i) {
+		char source[64];
+		unsigned int r = rand_r(&seed);
+		int digits = 1 + r % 19;
+		int point = r / 19 % (digits + 1);
+		char *s = source;
+		if (r & 0x80000000u)
+			*s++ = '-';
+		for (int d = 0; d < digits; ++d) {
+			if (d == point)
+				*s++ = '.';
+			*s++ = '0' + rand_r(&seed) % 10;
+		}
+		if (point == digits)
+			*s++ = '.', *s++ = '0';
+		if (i & 1)
+			sprintf(s, "e%d", (int)(rand_r(&seed) % 80) - 40);
+		else
+			*s = 0;
+		fail |= float_compare(source);
+
+		/* shortest round trip representations */
+		uint64_t bits = (uint64_t)rand_r(&seed) << 33 ^ (uint64_t)rand_r(&seed) << 11 ^ rand_r(&seed);
+		double d;
+		memcpy(&d, &bits, sizeof d);
+		if ((bits >> 52 & 0x7ff) != 0x7ff) { /* not NaN/Inf, -ffast-math does not check them */
+			sprintf(source, "%.17e", d);
+			fail |= float_compare(source);
+			sprintf(source, "%.15g", d);
+			if (strpbrk(source, ".e"))
+				fail |= float_compare(source);
+		}
+	}
+
+	if (setlocale(LC_NUMERIC, "de_DE.UTF-8") || setlocale(LC_NUMERIC, "ru_RU.UTF-8")) {
+		char text[] = "[0.5,1.25e300]";
+		jsn_t json[3];
+		if (json_parse(json, 3, text) != 3 || json_float(json + 1, 0.d) != 0.5 || json_float(json + 2, 0.d) != 1.25e300) {
+			printf("<<<%s>>> [FAILED] // depends on decimal point of locale\n", "[0.5,1.25e300]");
+			fail |= T_FAIL;
+		}
+		setlocale(LC_NUMERIC, "C");
 	}
 
 	return fail;
 }
+#endif
 
 
-#ifdef JSON_FLOATS
 /* ------------------------------------------------------------------------ */
-static int test_float()
+static int test_number2str()
 {
 	static const struct {
-		char const *text;
-		double floating;
+		jsn_number_t number;
+		char const *string;
 	} samples[] = {
-		 { "0", 0.d }
-		,{ "1", 1.d }
-		,{ "555", 555.d }
-		,{ "null", 0.d }
-		,{ "true", 1.d }
-		,{ "false", 0.d }
-		,{ "\"\"", 0.d }
-		,{ "\"123\"", 123.d }
+		 { 0, "0" }
+		,{ 7, "7" }
+		,{ -7, "-7" }
+		,{ 10, "10" }
+		,{ 99, "99" }
+		,{ -100, "-100" }
+		,{ 1234567, "1234567" }
+		,{ INT32_MAX, "2147483647" }
+		,{ INT32_MIN, "-2147483648" }
 #ifdef JSON_64BITS_INTEGERS
-		,{ "100000000000", 100000000000.d }
-#else
-		,{ "100000000000", 2147483647.d }
-#endif
-		,{ "1e4", 1e4 }
-#ifdef JSON_HEX_NUMBERS
-		,{ "\"0x123\"", 291.d }
+		,{ 100000000000, "100000000000" }
+		,{ INT64_MAX, "9223372036854775807" }
+		,{ INT64_MIN, "-9223372036854775808" }
 #endif
-		,{ "[]", 0.d }
-		,{ "[1]", 1.d }
-		,{ "{}", 0.d }
 	};
 
 	int fail = T_OK;
+	char buf[32];
 	for (int i = 0, n = sizeof samples / sizeof samples[0]; i < n; ++i) {
-		char text[256];
-		char const *source = samples[i].text;
-		jsn_t json[5];
-		strcpy(text, source);
-		int p = json_parse(json, sizeof json / sizeof json[0], text);
-		if (p <= 0) {
-			printf("<<<%s>>> [FAILED] // parsing %d\n", source, -p);
+		char *e = number2str(buf, buf + sizeof buf, samples[i].number);
+		if (strcmp(buf, samples[i].string) || e != buf + strlen(buf)) {
+			printf("<%s> but expected <%s> [FAILED] // number2str\n", buf, samples[i].string);
 			fail |= T_FAIL;
 		}
+	}
 
-		double result = json_float(json, 0.d);
-		double expected = samples[i].floating;
-		if (result == expected) {
-			//printf("[OK]\n");
-			continue;
-		}
-
-		printf("<<<%s>>> -> %f but expected %f [FAILED] // json_float\n", source, result, expected);
+	memset(buf, '#', sizeof buf);
+	if (number2str(buf, buf + 3, -12345) != buf + 6 || memcmp(buf, "-12#", 4)) {
+		printf("<%.4s> but expected <-12#> [FAILED] // number2str truncation\n", buf);
 		fail |= T_FAIL;
 	}
 
 	return fail;
 }
-#endif
 
 
 /* ------------------------------------------------------------------------ */
@@ -494,8 +1730,22 @@ static int test_string()
 			fail |= T_FAIL;
 		}
 
-		char const *result = json_string(json, 0);
 		char const *expected = samples[i].string;
+		char buf[JSN_NUMBER_STRING_SIZE], small[2];
+		char const *result = json_string_r(json, buf, sizeof buf, NULL);
+		int is_number = json->type == JS_NUMBER || json->type == JS_FLOAT;
+		if (!result || strcmp(result, expected) || (is_number && result != buf)) {
+			printf("<<<%s>>> -> \"%s\" but expected \"%s\" [FAILED] // json_string_r\n", source, result, expected);
+			fail |= T_FAIL;
+		}
+		errno = 0;
+		result = json_string_r(json, small, sizeof small, "#");
+		if (is_number && strlen(expected) >= sizeof small ? strcmp(result, "#") || errno != ENOBUFS : strcmp(result, expected)) {
+			printf("<<<%s>>> -> \"%s\" [FAILED] // json_string_r(%u)\n", source, result, (unsigned int)sizeof small);
+			fail |= T_FAIL;
+		}
+
+		result = json_string(json, 0);
 		if (!strcmp(result, expected)) {
 			//printf("[OK]\n");
 			continue;
@@ -508,6 +1758,60 @@ static int test_string()
 	return fail;
 }
 
+
+/* ------------------------------------------------------------------------ */
+/* every thread formats its own numbers of the shared tree by json_string() */
+typedef struct {
+	jsn_t *json;
+	int first, fail;
+} string_thread_t;
+
+static void *string_thread(void *arg)
+{
+	string_thread_t *t = arg;
+	for (int k = 0; k < 200; ++k)
+		for (int i = t->first; i < t->first + 100; ++i) {
+			char const *s[2] = { json_string(json_cell(t->json, i), NULL), json_string(json_cell(t->json, i), NULL) };
+			char expected[16];
+			sprintf(expected, "%d", i * 7);
+			t->fail |= strcmp(s[0], expected) || strcmp(s[1], expected) || s[0] == s[1];
+		}
+	return NULL;
+}
+
+
+/* ------------------------------------------------------------------------ */
+static int test_string_threads()
+{
+	char *text = malloc(8 * 100 * 8 + 2), *p = text;
+	for (int i = 0; i < 8 * 100; ++i)
+		p += sprintf(p, i ? ",%d" : "[%d", i * 7);
+	strcpy(p, "]");
+	jsn_t *json = malloc((8 * 100 + 1) * sizeof(jsn_t));
+	if (json_parse(json, 8 * 100 + 1, text) != 8 * 100 + 1) {
+		printf("    parsing [FAILED]\n");
+		return T_FAIL;
+	}
+
+	pthread_t threads[8];
+	string_thread_t args[8];
+	for (int i = 0; i < 8; ++i) {
+		args[i] = (string_thread_t){ .json = json, .first = i * 100 };
+		pthread_create(threads + i, NULL, string_thread, args + i);
+	}
+	int fail = T_OK;
+	for (int i = 0; i < 8; ++i) {
+		pthread_join(threads[i], NULL);
+		if (args[i].fail) {
+			printf("    thread %d json_string() [FAILED]\n", i);
+			fail |= T_FAIL;
+		}
+	}
+	free(json);
+	free(text);
+	return fail;
+}
+
 /* ------------------------------------------------------------------------ */
 static int test_json_item()
 {
@@ -584,6 +1888,313 @@ static int test_json_item()
 	return fail;
 }
 
+/* ------------------------------------------------------------------------ */
+static int test_json_items()
+{
+	char text[] = "{\"jsonrpc\":\"2.0\",\"method\":\"sum\",\"params\":[1,2],\"id\":7,\"method\":\"dup\"}";
+	char const *ids[] = { "error", "id", "jsonrpc", "method", "params" };
+	enum { IDS = sizeof ids / sizeof ids[0] };
+	jsn_t json[16], *items[IDS];
+
+	if (json_parse(json, 16, text) <= 0) {
+		printf("    json_parse() [FAILED]\n");
+		return T_FAIL;
+	}
+
+	int fail = T_OK;
+	int found = json_items(json, ids, items, IDS);
+	if (found != 4 || items[0] || json_number(items[1], 0) != 7 || strcmp(json_string(items[2], ""), "2.0")
+	 || strcmp(json_string(items[3], ""), "sum") || json_length(items[4]) != 2) {
+		printf("    json_items() -> %d [FAILED]\n", found);
+		fail |= T_FAIL;
+	}
+	if (json_items(json, ids + 1, items, 1) != 1 || items[0] != json_item(json, "id")) {
+		printf("    json_items(\"id\") [FAILED]\n");
+		fail |= T_FAIL;
+	}
+	if (json_items(json + 1, ids, items, IDS) != -1 || errno != ENOTDIR) {
+		printf("    json_items() of string [FAILED]\n");
+		fail |= T_FAIL;
+	}
+	return fail;
+}
+
+
+#ifdef JSON_PATH_FN
+/* ------------------------------------------------------------------------ */
+static jsn_t *path_get(jsn_t *json, char const *path)
+{
+	jsn_path_t *c = json_path_compile(path);
+	if (!c)
+		return NULL;
+
+	jsn_t *j = json_path_eval(c, json);
+	json_path_free(c);
+	return j;
+}
+#endif
+
+#ifdef JSON_LAZY_UNESCAPE
+/* ------------------------------------------------------------------------ */
+static int test_lazy_unescape()
+{
+	char text[] = "{\"a\\u0062\":\"x\\ny\",\"c\":\"plain\",\"d\":[\"\\\"q\\\"\"]}";
+	jsn_t json[8];
+	if (json_parse(json, 8, text) <= 0) {
+		printf("    json_parse() [FAILED]\n");
+		return T_FAIL;
+	}
+
+	int fail = T_OK;
+	if (!strchr(json[1].data.string, '\\') || strcmp(json[2].data.string, "plain")) {
+		printf("    strings are unescaped by parsing [FAILED]\n");
+		fail |= T_FAIL;
+	}
+	if (strcmp(json_id(json + 1), "ab") || json_item(json, "ab") != json + 1 || strcmp(json_string(json + 1, ""), "x\ny")) {
+		printf("    json_id()/json_item()/json_string() [FAILED]\n");
+		fail |= T_FAIL;
+	}
+	char result[64];
+	json_stringify(result, sizeof result, json);
+	if (strcmp(result, "{\"ab\":\"x\\ny\",\"c\":\"plain\",\"d\":[\"\\\"q\\\"\"]}")) {
+		printf("    json_stringify() -> %s [FAILED]\n", result);
+		fail |= T_FAIL;
+	}
+
+	/* a node built by hand is not unescaped even if its string follows a backslash */
+	char buf[] = "\\\\n";
+	jsn_t node = { .type = JS_STRING, .data.string = buf + 1 };
+	if (strcmp(json_string(&node, ""), "\\n") || strcmp(buf, "\\\\n")) {
+		printf("    json_string() of node built by hand -> %s [FAILED]\n", buf);
+		fail |= T_FAIL;
+	}
+	return fail;
+}
+#endif
+
+
+/* ------------------------------------------------------------------------ */
+/* json_count_nodes() must count the lookup tables exactly as json_parse() allocates them */
+static int test_count_parse(char const *source)
+{
+	char *text = strdup(source);
+	int nodes = json_count_nodes(source);
+	jsn_t *json = malloc((nodes > 0 ? nodes : 1) * sizeof(jsn_t));
+	int parsed = json_parse(json, nodes, text);
+	free(json);
+	free(text);
+	if (nodes <= 0 || parsed != nodes) {
+		printf("    <<<%.64s...>>> json_count_nodes() %d, json_parse() %d [FAILED]\n", source, nodes, parsed);
+		return T_FAIL;
+	}
+	return T_OK;
+}
+
+
+/* ------------------------------------------------------------------------ */
+static int test_wide_object()
+{
+	enum { KEYS = 200 };
+	char *source = malloc(KEYS * 40), *s = source;
+	s += sprintf(s, "[{\"obj\":{\"a\\u0062c\":1,\"k5\":5}},{");
+	for (int i = 0; i < KEYS; ++i)
+		s += sprintf(s, "\"k%d\":%d,", i, i);
+	s += sprintf(s, "\"k5\":-1,\"a\\u0062c\":{");
+	for (int i = 0; i < KEYS; ++i)
+		s += sprintf(s, "%s\"n%d\":%d", i ? "," : "", i, -i);
+	s += sprintf(s, "}}]");
+
+	int fail = test_count_parse(source);
+	char *text = strdup(source);
+	jsn_t *json = json_auto_parse(text, NULL);
+	if (!json) {
+		printf("    <<<%s>>> [FAILED] // parsing %m\n", source);
+		free(text);
+		free(source);
+		return T_FAIL;
+	}
+
+	jsn_t *obj = json_cell(json, 1);
+	for (int i = 0; i < KEYS; ++i) {
+		char id[16];
+		sprintf(id, "k%d", i);
+		if (json_number(json_item(obj, id), -1000) != i) {
+			printf("    json_item(\"%s\") -> %d [FAILED]\n", id, (int)json_number(json_item(obj, id), -1000));
+			fail |= T_FAIL;
+		}
+	}
+	if (json_item(obj, "zz") || json_item(obj, "") || json_item(obj, "k200")) {
+		printf("    json_item(\"zz\") [FAILED]\n");
+		fail |= T_FAIL;
+	}
+	char const *ids[] = { "k0", "k199", "k5", "zz" };
+	jsn_t *items[4];
+	if (json_items(obj, ids, items, 4) != 3 || json_number(items[1], -1) != 199 || json_number(items[2], -1) != 5 || items[3]) {
+		printf("    json_items() [FAILED]\n");
+		fail |= T_FAIL;
+	}
+#ifdef JSON_GET_FN
+	if (json_number(json_get(json, "[1].abc.n199"), 0) != -199 || json_number(json_get(json, "[0].obj.abc"), 0) != 1) {
+		printf("    json_get(\"[1].abc.n199\") [FAILED]\n");
+		fail |= T_FAIL;
+	}
+#endif
+#ifdef JSON_PATH_FN
+	if (json_number(path_get(json, "[1][\"a\\u0062c\"].n199"), 0) != -199 || path_get(json, "[1].abc.n200")) {
+		printf("    json_path_eval(\"[1][\\\"a\\\\u0062c\\\"].n199\") [FAILED]\n");
+		fail |= T_FAIL;
+	}
+#endif
+
+	char *result = malloc(KEYS * 40);
+	json_stringify(result, KEYS * 40, json);
+	for (char *e; (e = strstr(source, "\\u0062"));) /* unescape the sample */
+		*e = 'b', memmove(e + 1, e + 6, strlen(e + 6) + 1);
+	if (strcmp(result, source)) {
+		printf("    <<<%s>>> -> <%s> [FAILED] // serializing\n", source, result);
+		fail |= T_FAIL;
+	}
+
+	free(result);
+	free(json);
+	free(text);
+	free(source);
+	return fail;
+}
+
+
+/* ------------------------------------------------------------------------ */
+static int test_long_array(char const *item, char const *nested)
+{
+	enum { LENGTH = 300 };
+	char *source = malloc(LENGTH * 32), *s = source;
+	*s++ = '[';
+	for (int i = 0; i < LENGTH; ++i)
+		s += sprintf(s, i % 7 ? item : nested, i);
+	strcpy(s - 1, "]");
+
+	int fail = test_count_parse(source);
+	char *text = strdup(source);
+	jsn_t *json = json_auto_parse(text, NULL);
+	if (!json) {
+		printf("    <<<%s>>> [FAILED] // parsing %m\n", source);
+		free(text);
+		free(source);
+		return T_FAIL;
+	}
+
+	if (json_length(json) != LENGTH) {
+		printf("    json_length() -> %d [FAILED]\n", json_length(json));
+		fail |= T_FAIL;
+	}
+
+	for (int i = 0; i < LENGTH; ++i) {
+		jsn_t *cell = json_cell(json, i);
+		if (!cell || cell->id.number != i || json_number(cell->type == JS_NUMBER ? cell : cell + 1, -1) != i) {
+			printf("    json_cell(%d) [FAILED]\n", i);
+			fail |= T_FAIL;
+		}
+	}
+	if (json_cell(json, LENGTH) || json_cell(json, -1)) {
+		printf("    json_cell(%d) [FAILED]\n", LENGTH);
+		fail |= T_FAIL;
+	}
+#ifdef JSON_GET_FN
+	if (json_number(json_get(json, "[299]"), -1) != 299 && json_number(json_get(json, "[299]") + 1, -1) != 299) {
+		printf("    json_get(\"[299]\") [FAILED]\n");
+		fail |= T_FAIL;
+	}
+#endif
+
+	free(json);
+	free(text);
+	free(source);
+	return fail;
+}
+
+
+/* ------------------------------------------------------------------------ */
+static int test_long_arrays()
+{
+	/* flat and not flat arrays which are not the first nodes of the pool */
+	char source[512], *s = source;
+	s += sprintf(s, "{\"a\":[");
+	for (int i = 0; i < 40; ++i)
+		s += sprintf(s, i ? ",%d" : "%d", i);
+	s += sprintf(s, "],\"b\":[[");
+	for (int i = 0; i < 40; ++i)
+		s += sprintf(s, i ? ",%d" : "%d", i);
+	s += sprintf(s, "]");
+	for (int i = 0; i < 20; ++i)
+		s += sprintf(s, ",[%d]", i);
+	sprintf(s, "]}");
+
+	return test_count_parse(source)
+	     | test_long_array("%d,", "%d,")
+	     | test_long_array("%d,", "[%d],")
+	     | test_long_array("{\"a\":%d},", "{\"b\":%d},");
+}
+
+
+/* ------------------------------------------------------------------------ */
+static int test_far_tables()
+{
+	/* the last element is 45303 nodes long, so tables of the object and the array are farther
+	   than SHRT_MAX nodes and are not built with JSON_SHORT_NEXT */
+	enum { ITEMS = 16, SIDE = 150 };
+	char *big = malloc(2 * SIDE * (SIDE * 4 + 4) + 8), *s = big;
+	*s++ = '[';
+	for (int k = 0; k < 2; ++k) {
+		*s++ = '[';
+		for (int i = 0; i < SIDE; ++i) {
+			*s++ = '[';
+			for (int j = 0; j < SIDE; ++j)
+				s += sprintf(s, "%d,", j);
+			strcpy(s - 1, "],");
+			s += 1;
+		}
+		strcpy(s - 1, "],");
+		s += 1;
+	}
+	strcpy(s - 1, "]");
+
+	int fail = T_OK;
+	for (int is_object = 0; is_object < 2; ++is_object) {
+		char *source = malloc(strlen(big) + ITEMS * 16), *t = source;
+		*t++ = is_object ? '{' : '[';
+		for (int i = 0; i < ITEMS - 1; ++i)
+			t += sprintf(t, is_object ? "\"k%d\":%d," : "%d,", i, i);
+		if (is_object)
+			sprintf(t, "\"k%d\":%s}", ITEMS - 1, big);
+		else
+			sprintf(t, "%s]", big);
+
+		fail |= test_count_parse(source);
+		char *text = strdup(source);
+		jsn_t *json = json_auto_parse(text, NULL);
+		jsn_t *last = !json ? NULL : is_object ? json_item(json, "k15") : json_cell(json, ITEMS - 1);
+		jsn_t *first = !json ? NULL : is_object ? json_item(json, "k0") : json_cell(json, 0);
+		if (!last || json_length(last) != 2 || json_number(first, -1) != 0
+		 || json_number(json_cell(json_cell(json_cell(last, 1), SIDE - 1), SIDE - 1), -1) != SIDE - 1) {
+			printf("    %s of %d items with the last one of %d nodes [FAILED] (%m)\n",
+				is_object ? "object" : "array", ITEMS, 2 * SIDE * (SIDE + 1) + 1);
+			fail |= T_FAIL;
+		}
+#if defined(JSON_SHORT_NEXT) && (defined(JSON_HASH_INDEX) || defined(JSON_ARRAY_INDEX))
+		if (json && json->data.index) {
+			printf("    %s table at offset %d [FAILED] // should not be built\n", is_object ? "object" : "array", json->data.index);
+			fail |= T_FAIL;
+		}
+#endif
+		free(json);
+		free(text);
+		free(source);
+	}
+	free(big);
+	return fail;
+}
+
+
 /* ------------------------------------------------------------------------ */
 static int test_json_cell()
 {
@@ -662,7 +2273,8 @@ static int test_get()
 					"\"key\":123"
 				"}"
 			"]"
-		"}"
+		"},"
+		"\"snake_key_\":7"
 	"}";
 
 	char const *good_pathes[] = {
@@ -673,7 +2285,8 @@ static int test_get()
 		".array[3]", "3",
 		".obj.ololo[1]", "\"b\"",
 		".obj.ololo[2]", "{\"key\":123}",
-		".obj.ololo[2].key", "123"
+		".obj.ololo[2].key", "123",
+		".snake_key_", "7"
 	};
 
 	char const *bad_pathes[] = {
@@ -703,6 +2316,10 @@ static int test_get()
 		char const *path = bad_pathes[i];
 		//printf("    <<<%s>>>...\n", path);
 		jsn_t *j = json_get(json, path);
+#ifdef JSON_PATH_FN
+		if (!j)
+			j = path_get(json, path);
+#endif
 		if (j) {
 			json_stringify(result, sizeof result, j);
 			printf("    <<<%s>>> -> <%s>\n but is should be FAILED\n", path, result);
@@ -720,6 +2337,12 @@ static int test_get()
 			printf("    <<<%s>>> // json_get '%m' [FAILED]\n", path);
 			fail |= T_FAIL;
 		}
+#ifdef JSON_PATH_FN
+		if (path_get(json, path) != j) {
+			printf("    <<<%s>>> // json_path_eval [FAILED]\n", path);
+			fail |= T_FAIL;
+		}
+#endif
 		json_stringify(result, sizeof result, j);
 		if (strcmp(exp, result)) {
 			printf("    <<<%s>>> -> <%s>\n but expected <%s> [FAILED] // serializing\n", path, result, exp);
@@ -763,34 +2386,120 @@ int main(int argc, char *argv[])
 #endif
 		" | sizeof jsn_t: %u\n", (unsigned int)sizeof (jsn_t));
 
+	int fail = T_OK;
+
 	printf("Test json_parse()\n");
-	test_json_parse();
+	fail |= test_json_parse();
+
+	printf("Test long strings\n");
+	fail |= test_long_strings();
+
+	printf("Test strings at the page end\n");
+	fail |= test_page_end();
+
+	printf("Test strings at text blocks edges\n");
+	fail |= test_block_edges();
+
+	printf("Test json_count_nodes()\n");
+	fail |= test_json_count_nodes();
 
 	printf("Test json_auto_parse()\n");
-	test_json_auto_parse();
+	fail |= test_json_auto_parse();
+
+#ifdef JSON_PARSE_N_FN
+	printf("Test json_parse_n()\n");
+	fail |= test_json_parse_n();
+#endif
+
+#ifdef JSON_SAX_FN
+	printf("Test json_sax_parse()\n");
+	fail |= test_json_sax_parse();
+#endif
+
+#ifdef JSON_FEED_FN
+	printf("Test json_parser_feed()\n");
+	fail |= test_feed();
+#endif
+
+#ifdef JSON_PARSE_NEXT_FN
+	printf("Test json_parse_next()\n");
+	fail |= test_parse_next();
+#endif
+
+#ifdef JSON_NDJSON_FN
+	printf("Test json_ndjson_parse()\n");
+	fail |= test_ndjson();
+#endif
+
+	printf("Test nesting depth\n");
+	fail |= test_depth();
+
+#ifdef JSON_STRINGIFY_STREAM_FN
+	printf("Test json_stringify_cb()\n");
+	fail |= test_stringify_stream();
+#endif
+
+#ifdef JSON_ARENA_FN
+	printf("Test json_arena_parse()\n");
+	fail |= test_arena();
+#endif
+
+#ifdef JSON_STATS
+	printf("Test json_stats()\n");
+	fail |= test_stats();
+#endif
 
 	printf("Test json_number()\n");
-	test_number();
+	fail |= test_number();
 
 	printf("Test json_boolean()\n");
-	test_boolean();
+	fail |= test_boolean();
 
 #ifdef JSON_FLOATS
 	printf("Test json_float()\n");
-	test_float();
+	fail |= test_float();
+
+	printf("Test float2str()\n");
+	fail |= test_float2str();
+
+	printf("Test float conversion exactness\n");
+	fail |= test_float_exact();
 #endif
 
+	printf("Test number2str()\n");
+	fail |= test_number2str();
+
 	printf("Test json_string()\n");
-	test_string();
+	fail |= test_string();
+
+	printf("Test json_string() in threads\n");
+	fail |= test_string_threads();
 
 	printf("Test json_get()\n");
-	test_get();
+	fail |= test_get();
 
 	printf("Test json_item()\n");
-	test_json_item();
+	fail |= test_json_item();
+
+	printf("Test json_items()\n");
+	fail |= test_json_items();
+
+#ifdef JSON_LAZY_UNESCAPE
+	printf("Test lazy unescaping\n");
+	fail |= test_lazy_unescape();
+#endif
+
+	printf("Test wide objects\n");
+	fail |= test_wide_object();
+
+	printf("Test long arrays\n");
+	fail |= test_long_arrays();
+
+	printf("Test lookup tables far from arrays and objects\n");
+	fail |= test_far_tables();
 
 	printf("Test json_cell()\n");
-	test_json_cell();
+	fail |= test_json_cell();
 
-	return 0;
+	return fail ? 1 : 0;
 }
@@ -4,6 +4,11 @@
 #JSON_FLOATS
 #JSON_64BITS_INTEGERS
 #JSON_HEX_NUMBERS
+#JSON_SHORT_NEXT
+#JSON_PACKED
+#feature groups of test_features():
+#  si JSON_SIMD, ts JSON_TWO_STAGE, ix JSON_HASH_INDEX and JSON_ARRAY_INDEX,
+#  lu JSON_LAZY_UNESCAPE, st JSON_STATS, ac JSON_AUTO_PARSE_COUNT, nd JSON_NDJSON_FN
 
 test_basic()
 {
@@ -11,9 +16,10 @@ test_basic()
 	echo "run test $*"
 
 	local CMAKE_OPTS=""
-	local hx fl wi sn ohx ofl owi osn
+	local hx fl wi sn pk ft ohx ofl owi osn opk osi ots oix olu ost oac ond
 	hx="-"; fl="-"; wi="-"; sn="-"; pk="-"
 	ohx="OFF"; ofl="OFF"; owi="OFF"; osn="OFF"; opk="OFF"
+	ft=""; osi="OFF"; ots="OFF"; oix="OFF"; olu="OFF"; ost="OFF"; oac="OFF"; ond="OFF"
 	for a in $*; do
 		case $a in
 		hx)
@@ -36,12 +42,40 @@ test_basic()
 			pk="p"
 			opk="ON"
 			;;
+		si)
+			ft="${ft}_si"
+			osi="ON"
+			;;
+		ts)
+			ft="${ft}_ts"
+			ots="ON"
+			;;
+		ix)
+			ft="${ft}_ix"
+			oix="ON"
+			;;
+		lu)
+			ft="${ft}_lu"
+			olu="ON"
+			;;
+		st)
+			ft="${ft}_st"
+			ost="ON"
+			;;
+		ac)
+			ft="${ft}_ac"
+			oac="ON"
+			;;
+		nd)
+			ft="${ft}_nd"
+			ond="ON"
+			;;
 		esac
 	done
 
 	local name
-	name=nj_tests_$hx$wi$fl$sn$pk
-	cmake -DJSON_HEX_NUMBERS=$ohx -DJSON_64BITS_INTEGERS=$owi -DJSON_FLOATS=$ofl -DJSON_SHORT_NEXT=$osn -DJSON_PACKED=$opk -DBUILD_TESTS=ON -DJSON_AUTO_PARSE_POOL_START_SIZE=4 -DJSON_AUTO_PARSE_POOL_INCREASE=n+4 . && make || exit 1
+	name=nj_tests_$hx$wi$fl$sn$pk$ft
+	cmake -DJSON_HEX_NUMBERS=$ohx -DJSON_64BITS_INTEGERS=$owi -DJSON_FLOATS=$ofl -DJSON_SHORT_NEXT=$osn -DJSON_PACKED=$opk -DJSON_SIMD=$osi -DJSON_TWO_STAGE=$ots -DJSON_HASH_INDEX=$oix -DJSON_ARRAY_INDEX=$oix -DJSON_LAZY_UNESCAPE=$olu -DJSON_STATS=$ost -DJSON_AUTO_PARSE_COUNT=$oac -DJSON_NDJSON_FN=$ond -DBUILD_TESTS=ON -DJSON_AUTO_PARSE_POOL_START_SIZE=4 -DJSON_AUTO_PARSE_POOL_INCREASE=n+4 . && make || exit 1
 	mv ./tests $name
 	echo "./$name || exit 1" >> tests.sh
 	echo
@@ -72,6 +106,11 @@ test_packet_next()
 	test_short_next $* && test_short_next $* pk
 }
 
+test_features()
+{
+	test_packet_next $* && test_packet_next $* si ts ix && test_packet_next $* si lu st ac nd && test_packet_next $* ix lu ac
+}
+
 case $1 in
 clean)
 	rm nj_tests* tests.sh
@@ -80,5 +119,5 @@ clean)
 esac
 
 echo "#!/bin/sh" > tests.sh
-test_packet_next
+test_features
 chmod +x tests.sh
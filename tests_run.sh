@@ -4,6 +4,8 @@
 #JSON_FLOATS
 #JSON_64BITS_INTEGERS
 #JSON_HEX_NUMBERS
+#JSON_SHORT_NEXT
+#feature groups of test_features() on top of them
 
 test_basic()
 {
@@ -32,4 +34,14 @@ test_short_next()
 	test_floats $* -DJSON_SHORT_NEXT=ON && test_floats $* -DJSON_SHORT_NEXT=OFF
 }
 
-test_short_next
+FEATURES_OFF="-DJSON_SIMD=OFF -DJSON_TWO_STAGE=OFF -DJSON_HASH_INDEX=OFF -DJSON_ARRAY_INDEX=OFF -DJSON_LAZY_UNESCAPE=OFF -DJSON_STATS=OFF -DJSON_AUTO_PARSE_COUNT=OFF -DJSON_NDJSON_FN=OFF"
+
+test_features()
+{
+	test_short_next $FEATURES_OFF &&
+	test_short_next $FEATURES_OFF -DJSON_SIMD=ON -DJSON_TWO_STAGE=ON -DJSON_HASH_INDEX=ON -DJSON_ARRAY_INDEX=ON &&
+	test_short_next $FEATURES_OFF -DJSON_SIMD=ON -DJSON_LAZY_UNESCAPE=ON -DJSON_STATS=ON -DJSON_AUTO_PARSE_COUNT=ON -DJSON_NDJSON_FN=ON &&
+	test_short_next $FEATURES_OFF -DJSON_HASH_INDEX=ON -DJSON_ARRAY_INDEX=ON -DJSON_LAZY_UNESCAPE=ON -DJSON_AUTO_PARSE_COUNT=ON
+}
+
+test_features